@@ -204,6 +204,8 @@ void loop()
     Serial.print(100 - (100 * my_mdns.buffer_size_fail / my_mdns.packet_count));
     Serial.print("%\nLargest packet size: ");
     Serial.println(my_mdns.largest_packet_seen);
+    Serial.print("Duplicate packets dropped: ");
+    Serial.println(my_mdns.duplicate_count);
   }
 #endif
 
@@ -0,0 +1,215 @@
+// Measures the receive path through mdns::PacketQueue on the host.
+//
+// A reader thread pushes synthetic mDNS responses into the queue, as a UDP
+// receive callback would on the ESP8266, while the main thread drains it.
+// Ingest (Push/Pop only) and parse (MDns::loop() on a full queue) are timed
+// separately, then together with the reader running at --rate.
+
+#include <mdns.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Options {
+  unsigned long packets;
+  unsigned int records;
+  unsigned long rate;
+};
+
+// Slots in the queue under test.
+#define BENCH_QUEUE_SLOTS 32
+
+typedef mdns::BasicPacketQueue<BENCH_QUEUE_SLOTS, MAX_PACKET_SIZE> Queue;
+typedef std::chrono::steady_clock Clock;
+
+double SecondsSince(const Clock::time_point start) {
+  return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+void AppendName(std::vector<byte>* packet, const char* name) {
+  while (*name) {
+    const char* end = strchr(name, '.');
+    const size_t len = end ? end - name : strlen(name);
+    packet->push_back(len);
+    packet->insert(packet->end(), name, name + len);
+    name += end ? len + 1 : len;
+  }
+  packet->push_back(0);
+}
+
+// A response with one A record for each of hostN.local.
+std::vector<byte> BuildResponse(const unsigned int records) {
+  std::vector<byte> packet = {0, 0, 0x84, 0, 0, 0, 0, (byte)records, 0, 0, 0, 0};
+  for (unsigned int i = 0; i < records; ++i) {
+    char name[32];
+    sprintf(name, "host%u.local", i);
+    AppendName(&packet, name);
+    const byte fixed[] = {0, MDNS_TYPE_A, 0x80, 1, 0, 0, 0, 120, 0, 4, 10, 0, 0, (byte)i};
+    packet.insert(packet.end(), fixed, fixed + sizeof(fixed));
+  }
+  return packet;
+}
+
+// Set the unused DNS ID field so consecutive copies of packet differ and are
+// not dropped by MDns' duplicate filter.
+void SetSequence(std::vector<byte>* packet, const unsigned long sequence) {
+  (*packet)[0] = (sequence >> 8) & 0xFF;
+  (*packet)[1] = sequence & 0xFF;
+}
+
+// Push count numbered copies of packet, waiting while the queue is full unless
+// rate is set, in which case pushes are paced and a full queue drops the packet.
+// Waits yield so the benchmark also works on a single core.
+void Produce(Queue* queue, std::vector<byte> packet, const unsigned long count,
+             const unsigned long rate) {
+  const IPAddress src(10, 0, 0, 2);
+  const IPAddress dst(224, 0, 0, 251);
+  const Clock::time_point start = Clock::now();
+  for (unsigned long i = 0; i < count; ++i) {
+    if (rate) {
+      const Clock::time_point due = start + std::chrono::nanoseconds(i * 1000000000ULL / rate);
+      while (Clock::now() < due) {
+        std::this_thread::yield();
+      }
+    } else {
+      while (queue->count() >= BENCH_QUEUE_SLOTS) {
+        std::this_thread::yield();
+      }
+    }
+    SetSequence(&packet, i);
+    queue->Push(packet.data(), packet.size(), src, dst);
+  }
+}
+
+void Report(const char* phase, const unsigned long packets, const double seconds,
+            const unsigned long dropped, const unsigned long answers) {
+  printf("%-8s %10lu %10.3f %12.0f %10lu %10lu\n", phase, packets, seconds * 1000.0,
+         packets / seconds, dropped, answers);
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --packets N            Datagrams pushed in each phase. (Default 200000)\n"
+          "  --records N            A records in each datagram. (Default 4)\n"
+          "  --rate N               Datagrams per second pushed by the reader thread in the\n"
+          "                         combined phase. 0 pushes as fast as the queue allows.\n"
+          "                         (Default 0)\n",
+          program);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.packets = 200000;
+  options.records = 4;
+  options.rate = 0;
+
+  for (int i = 1; i < argc; i += 2) {
+    const std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      Usage(argv[0]);
+      return 1;
+    }
+    const unsigned long value = strtoul(argv[i + 1], NULL, 10);
+    if (arg == "--packets") {
+      options.packets = value;
+    } else if (arg == "--records") {
+      options.records = value;
+    } else if (arg == "--rate") {
+      options.rate = value;
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<byte> packet = BuildResponse(options.records);
+  unsigned long answers = 0;
+  mdns::MDns mdns(NULL, NULL, [&answers](const mdns::Answer* answer) {
+    (void)answer;
+    answers++;
+  });
+  std::unique_ptr<Queue> queue(new Queue);
+  mdns.setReceiveQueue(queue.get());
+
+  printf("%u slots, %zu byte datagrams, %u records each\n", BENCH_QUEUE_SLOTS, packet.size(),
+         options.records);
+  printf("%-8s %10s %10s %12s %10s %10s\n", "phase", "packets", "ms", "pkts/s", "dropped",
+         "answers");
+
+  // Ingest: reader thread against a consumer that only copies packets out.
+  {
+    byte buffer[MAX_PACKET_SIZE];
+    IPAddress src, dst;
+    unsigned int orig_len;
+    unsigned long popped = 0;
+    const Clock::time_point start = Clock::now();
+    std::thread reader(Produce, queue.get(), packet, options.packets, 0);
+    while (popped < options.packets) {
+      if (queue->Pop(buffer, sizeof(buffer), &src, &dst, &orig_len)) {
+        popped++;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    reader.join();
+    Report("ingest", popped, SecondsSince(start), queue->dropped(), 0);
+  }
+
+  // Parse: MDns::loop() draining a full queue, with no producer running.
+  {
+    double seconds = 0;
+    unsigned long parsed = 0;
+    answers = 0;
+    while (parsed < options.packets) {
+      while (queue->count() < BENCH_QUEUE_SLOTS && parsed + queue->count() < options.packets) {
+        SetSequence(&packet, parsed + queue->count());
+        queue->Push(packet.data(), packet.size(), IPAddress(10, 0, 0, 2),
+                    IPAddress(224, 0, 0, 251));
+      }
+      const unsigned int batch = queue->count();
+      const Clock::time_point start = Clock::now();
+      for (unsigned int i = 0; i < batch; ++i) {
+        mdns.loop();
+      }
+      seconds += SecondsSince(start);
+      parsed += batch;
+    }
+    Report("parse", parsed, seconds, 0, answers);
+  }
+
+  // Combined: reader thread at --rate while MDns::loop() parses.
+  {
+    const unsigned long dropped_before = queue->dropped();
+    answers = 0;
+    const Clock::time_point start = Clock::now();
+    std::atomic<bool> done(false);
+    std::thread reader([&]() {
+      Produce(queue.get(), packet, options.packets, options.rate);
+      done = true;
+    });
+    while (!done || queue->count()) {
+      if (queue->count()) {
+        mdns.loop();
+      } else {
+        std::this_thread::yield();
+      }
+    }
+    reader.join();
+    const unsigned long dropped = queue->dropped() - dropped_before;
+    Report("combined", options.packets - dropped, SecondsSince(start), dropped, answers);
+  }
+  return 0;
+}
@@ -0,0 +1,23 @@
+// Print that writes to a stdio FILE, eg: to save PacketCapture::WritePcap()
+// output on the host.
+#ifndef SIMULATOR_FILE_PRINT_H
+#define SIMULATOR_FILE_PRINT_H
+
+#include <Arduino.h>
+
+namespace sim {
+
+class FilePrint : public Print {
+ public:
+  explicit FilePrint(FILE* file) : file_(file) {}
+
+  size_t write(uint8_t value) { return fwrite(&value, 1, 1, file_); }
+  size_t write(const uint8_t* buffer, size_t size) { return fwrite(buffer, 1, size, file_); }
+
+ private:
+  FILE* file_;
+};
+
+}  // namespace sim
+
+#endif  // SIMULATOR_FILE_PRINT_H
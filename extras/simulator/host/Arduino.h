@@ -0,0 +1,74 @@
+// Host stand-in for the parts of the Arduino API used by the mdns library.
+#ifndef ARDUINO_H
+#define ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <functional>
+
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+// Provided by the simulated network's virtual clock.
+unsigned long millis();
+void delay(unsigned long ms);
+void yield();
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+
+  size_t print(const char* value);
+  size_t print(char value);
+  size_t print(int value, int base = DEC);
+  size_t print(unsigned int value, int base = DEC);
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+
+  size_t println();
+  size_t println(const char* value);
+  size_t println(char value);
+  size_t println(int value, int base = DEC);
+  size_t println(unsigned int value, int base = DEC);
+  size_t println(long value, int base = DEC);
+  size_t println(unsigned long value, int base = DEC);
+};
+
+class IPAddress {
+ public:
+  IPAddress();
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d);
+  IPAddress(uint32_t address);
+
+  operator uint32_t() const;
+  bool operator==(const IPAddress& other) const;
+  bool operator!=(const IPAddress& other) const { return !(*this == other); }
+  uint8_t operator[](int index) const { return bytes_[index]; }
+  uint8_t& operator[](int index) { return bytes_[index]; }
+
+ private:
+  uint8_t bytes_[4];
+};
+
+// Writes to stdout.
+class HardwareSerial : public Print {
+ public:
+  void begin(unsigned long baud) { (void)baud; }
+  size_t write(uint8_t value);
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif  // ARDUINO_H
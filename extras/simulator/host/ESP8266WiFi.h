@@ -0,0 +1,15 @@
+// Host stand-in for ESP8266WiFi.h. localIP() is the address of the simulated
+// node currently running.
+#ifndef ESP8266WIFI_H
+#define ESP8266WIFI_H
+
+#include <Arduino.h>
+
+class ESP8266WiFiClass {
+ public:
+  IPAddress localIP();
+};
+
+extern ESP8266WiFiClass WiFi;
+
+#endif  // ESP8266WIFI_H
@@ -0,0 +1,26 @@
+// Host stand-in for WiFiUdp.h. Packets are sent and received on the simulated
+// network by the node currently running.
+#ifndef WIFIUDP_H
+#define WIFIUDP_H
+
+#include <Arduino.h>
+
+class WiFiUDP {
+ public:
+  uint8_t begin(uint16_t port);
+  uint8_t beginMulticast(IPAddress interface_address, IPAddress multicast, uint16_t port);
+  void stop();
+
+  int parsePacket();
+  int read(uint8_t* buffer, size_t len);
+  IPAddress remoteIP();
+  IPAddress destinationIP();
+
+  int beginPacket(IPAddress address, uint16_t port);
+  int beginPacketMulticast(IPAddress multicast, uint16_t port, IPAddress interface_address,
+                           int ttl);
+  size_t write(const uint8_t* buffer, size_t size);
+  int endPacket();
+};
+
+#endif  // WIFIUDP_H
@@ -0,0 +1,136 @@
+#include <Arduino.h>
+
+#include <random>
+
+HardwareSerial Serial;
+
+namespace {
+
+std::mt19937 generator;
+
+size_t printNumber(Print* out, unsigned long value, bool negative, int base) {
+  char digits[34];
+  int pos = sizeof(digits);
+  digits[--pos] = '\0';
+  do {
+    const int digit = value % base;
+    digits[--pos] = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  if (negative) {
+    digits[--pos] = '-';
+  }
+  return out->print(digits + pos);
+}
+
+}  // namespace
+
+void yield() {}
+
+long random(long max) {
+  return random(0, max);
+}
+
+long random(long min, long max) {
+  if (max <= min) {
+    return min;
+  }
+  return min + (long)(generator() % (unsigned long)(max - min));
+}
+
+void randomSeed(unsigned long seed) {
+  generator.seed(seed);
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  size_t n = 0;
+  while (size--) {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+size_t Print::print(const char* value) {
+  return write((const uint8_t*)value, strlen(value));
+}
+
+size_t Print::print(char value) {
+  return write((uint8_t)value);
+}
+
+size_t Print::print(int value, int base) {
+  return print((long)value, base);
+}
+
+size_t Print::print(unsigned int value, int base) {
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(long value, int base) {
+  if (base == DEC && value < 0) {
+    return printNumber(this, -(unsigned long)value, true, base);
+  }
+  return printNumber(this, value, false, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  return printNumber(this, value, false, base);
+}
+
+size_t Print::println() {
+  return print("\r\n");
+}
+
+size_t Print::println(const char* value) {
+  return print(value) + println();
+}
+
+size_t Print::println(char value) {
+  return print(value) + println();
+}
+
+size_t Print::println(int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned int value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t Print::println(unsigned long value, int base) {
+  return print(value, base) + println();
+}
+
+size_t HardwareSerial::write(uint8_t value) {
+  return fputc(value, stdout) == EOF ? 0 : 1;
+}
+
+IPAddress::IPAddress() {
+  memset(bytes_, 0, sizeof(bytes_));
+}
+
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) {
+  bytes_[0] = a;
+  bytes_[1] = b;
+  bytes_[2] = c;
+  bytes_[3] = d;
+}
+
+IPAddress::IPAddress(uint32_t address) {
+  // Network byte order in memory, as on the ESP8266.
+  memcpy(bytes_, &address, sizeof(bytes_));
+}
+
+IPAddress::operator uint32_t() const {
+  uint32_t address;
+  memcpy(&address, bytes_, sizeof(address));
+  return address;
+}
+
+bool IPAddress::operator==(const IPAddress& other) const {
+  return memcmp(bytes_, other.bytes_, sizeof(bytes_)) == 0;
+}
@@ -0,0 +1,295 @@
+#include "network.h"
+
+#include <ESP8266WiFi.h>
+#include <WiFiUdp.h>
+#include <time.h>
+
+#include <algorithm>
+
+ESP8266WiFiClass WiFi;
+
+namespace sim {
+
+namespace {
+
+const IPAddress kMulticast(224, 0, 0, 251);
+
+// Orders Node::inbox as a min-heap.
+bool LaterDatagram(const Datagram& a, const Datagram& b) {
+  if (a.deliver_at != b.deliver_at) {
+    return (long)(a.deliver_at - b.deliver_at) > 0;
+  }
+  return a.sequence > b.sequence;
+}
+
+unsigned long long ThreadCpuNanoseconds() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+}  // namespace
+
+Network* Network::active_ = NULL;
+
+bool Node::PacketDue(unsigned long now) const {
+  return !inbox.empty() && (long)(inbox.front().deliver_at - now) <= 0;
+}
+
+Network::Network(unsigned long seed) :
+    loss(0.0),
+    latency_ms(1),
+    jitter_ms(0),
+    packets_on_bus(0),
+    bytes_on_bus(0),
+    query_packets(0),
+    response_packets(0),
+    deliveries(0),
+    dropped(0),
+    peak_packets_per_second(0),
+    generator_(seed),
+    now_(0),
+    sequence_(0),
+    second_start_(0),
+    second_packets_(0),
+    current_(NULL) {
+  randomSeed(seed);
+  active_ = this;
+}
+
+Network::~Network() {
+  if (active_ == this) {
+    active_ = NULL;
+  }
+}
+
+Node& Network::AddNode(const IPAddress& ip) {
+  nodes_.push_back(std::unique_ptr<Node>(new Node(ip)));
+  return *nodes_.back();
+}
+
+void Network::RunOnNode(Node& node, const std::function<void()>& fn) {
+  Node* const previous = current_;
+  current_ = &node;
+  const unsigned long long start = ThreadCpuNanoseconds();
+  fn();
+  node.stats.cpu_ns += ThreadCpuNanoseconds() - start;
+  current_ = previous;
+}
+
+void Network::RunUntil(unsigned long end_ms) {
+  while (true) {
+    // Advance to the earliest packet delivery or node deadline.
+    unsigned long next = end_ms;
+    for (auto& node : nodes_) {
+      if ((long)(node->wake_at - next) < 0) {
+        next = node->wake_at;
+      }
+      if (!node->inbox.empty() && (long)(node->inbox.front().deliver_at - next) < 0) {
+        next = node->inbox.front().deliver_at;
+      }
+    }
+    if ((long)(next - now_) > 0) {
+      now_ = next;
+    }
+    if ((long)(now_ - end_ms) >= 0) {
+      return;
+    }
+
+    for (auto& node : nodes_) {
+      Node& n = *node;
+      if ((long)(n.wake_at - now_) > 0 && !n.PacketDue(now_)) {
+        continue;
+      }
+      RunOnNode(n, [&]() {
+        // Keep running the node while it consumes waiting packets.
+        do {
+          const size_t waiting = n.inbox.size();
+          n.loop();
+          n.stats.loop_calls++;
+          if (n.inbox.size() == waiting) {
+            break;
+          }
+        } while (n.PacketDue(now_));
+        n.wake_at = n.next_deadline ? n.next_deadline() : now_ + 1000;
+        if ((long)(n.wake_at - (now_ + n.slept_ms)) < 0) {
+          // Still asleep until the end of any delay().
+          n.wake_at = now_ + n.slept_ms;
+        }
+      });
+      n.slept_ms = 0;
+      if ((long)(n.wake_at - now_) <= 0) {
+        // Never run a node twice at the same instant.
+        n.wake_at = now_ + 1;
+      }
+    }
+  }
+}
+
+void Network::Transmit(Node& sender) {
+  Datagram& datagram = sender.tx;
+  sender.stats.packets_sent++;
+  sender.stats.bytes_sent += datagram.data.size();
+  packets_on_bus++;
+  bytes_on_bus += datagram.data.size();
+  if (datagram.data.size() > 2 && (datagram.data[2] & 0b10000000)) {
+    response_packets++;
+  } else {
+    query_packets++;
+  }
+
+  if (now_ - second_start_ >= 1000) {
+    second_start_ = now_ - (now_ % 1000);
+    second_packets_ = 0;
+  }
+  second_packets_++;
+  peak_packets_per_second = std::max(peak_packets_per_second, second_packets_);
+
+  for (auto& node : nodes_) {
+    if (node.get() == &sender) {
+      continue;
+    }
+    if (datagram.dst == kMulticast || datagram.dst == node->ip) {
+      Deliver(*node, datagram);
+    }
+  }
+}
+
+void Network::Deliver(Node& receiver, const Datagram& datagram) {
+  if (loss > 0.0 && std::uniform_real_distribution<double>(0.0, 1.0)(generator_) < loss) {
+    dropped++;
+    return;
+  }
+  Datagram copy = datagram;
+  copy.deliver_at = local_now() + latency_ms;
+  if (jitter_ms) {
+    copy.deliver_at += generator_() % (jitter_ms + 1);
+  }
+  copy.sequence = sequence_++;
+  receiver.inbox.push_back(copy);
+  std::push_heap(receiver.inbox.begin(), receiver.inbox.end(), LaterDatagram);
+  deliveries++;
+}
+
+}  // namespace sim
+
+using sim::Network;
+using sim::Node;
+
+unsigned long millis() {
+  return Network::active() ? Network::active()->local_now() : 0;
+}
+
+void delay(unsigned long ms) {
+  // A node sleeping only moves its own clock, so other nodes are unaffected.
+  // Outside any node, eg: a lone sketch, the whole network sleeps.
+  Network* const network = Network::active();
+  if (!network) {
+    return;
+  }
+  if (network->current()) {
+    network->current()->slept_ms += ms;
+  } else {
+    network->now_ += ms;
+  }
+}
+
+IPAddress ESP8266WiFiClass::localIP() {
+  Network* const network = Network::active();
+  if (network && network->current()) {
+    return network->current()->ip;
+  }
+  return IPAddress();
+}
+
+uint8_t WiFiUDP::begin(uint16_t port) {
+  (void)port;
+  return 1;
+}
+
+uint8_t WiFiUDP::beginMulticast(IPAddress interface_address, IPAddress multicast,
+                                uint16_t port) {
+  (void)interface_address;
+  (void)multicast;
+  (void)port;
+  return 1;
+}
+
+void WiFiUDP::stop() {}
+
+int WiFiUDP::parsePacket() {
+  Network* const network = Network::active();
+  Node* const node = network ? network->current() : NULL;
+  if (!node || !node->PacketDue(network->now())) {
+    return 0;
+  }
+  std::pop_heap(node->inbox.begin(), node->inbox.end(), sim::LaterDatagram);
+  node->rx = node->inbox.back();
+  node->inbox.pop_back();
+  node->rx_pos = 0;
+  node->stats.packets_received++;
+  node->stats.bytes_received += node->rx.data.size();
+  return node->rx.data.size();
+}
+
+int WiFiUDP::read(uint8_t* buffer, size_t len) {
+  Node* const node = Network::active() ? Network::active()->current() : NULL;
+  if (!node) {
+    return 0;
+  }
+  const size_t available = node->rx.data.size() - node->rx_pos;
+  if (len > available) {
+    len = available;
+  }
+  memcpy(buffer, node->rx.data.data() + node->rx_pos, len);
+  node->rx_pos += len;
+  return len;
+}
+
+IPAddress WiFiUDP::remoteIP() {
+  Node* const node = Network::active() ? Network::active()->current() : NULL;
+  return node ? node->rx.src : IPAddress();
+}
+
+IPAddress WiFiUDP::destinationIP() {
+  Node* const node = Network::active() ? Network::active()->current() : NULL;
+  return node ? node->rx.dst : IPAddress();
+}
+
+int WiFiUDP::beginPacket(IPAddress address, uint16_t port) {
+  (void)port;
+  Node* const node = Network::active() ? Network::active()->current() : NULL;
+  if (!node) {
+    return 0;
+  }
+  node->tx.src = node->ip;
+  node->tx.dst = address;
+  node->tx.data.clear();
+  return 1;
+}
+
+int WiFiUDP::beginPacketMulticast(IPAddress multicast, uint16_t port,
+                                  IPAddress interface_address, int ttl) {
+  (void)interface_address;
+  (void)ttl;
+  return beginPacket(multicast, port);
+}
+
+size_t WiFiUDP::write(const uint8_t* buffer, size_t size) {
+  Node* const node = Network::active() ? Network::active()->current() : NULL;
+  if (!node) {
+    return 0;
+  }
+  node->tx.data.insert(node->tx.data.end(), buffer, buffer + size);
+  return size;
+}
+
+int WiFiUDP::endPacket() {
+  Network* const network = Network::active();
+  Node* const node = network ? network->current() : NULL;
+  if (!node) {
+    return 0;
+  }
+  network->Transmit(*node);
+  return 1;
+}
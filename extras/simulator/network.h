@@ -0,0 +1,135 @@
+// Deterministic in-memory multicast network for running many MDns instances in
+// one process.
+//
+// Each simulated node supplies a loop function that drives its MDns instance.
+// While a node's loop runs, the host WiFi, WiFiUDP and millis() stand-ins in
+// host/ act on behalf of that node, so the library's real loop() and Send()
+// code paths are exercised. Time only advances between node runs, so results
+// depend on the seed alone. delay() inside a node's loop only moves that node's
+// own clock; the node is not run again until its sleep has passed.
+#ifndef SIMULATOR_NETWORK_H
+#define SIMULATOR_NETWORK_H
+
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace sim {
+
+// A datagram in flight or waiting in a node's inbox.
+struct Datagram {
+  unsigned long deliver_at;    // Virtual time it arrives.
+  unsigned long sequence;      // Keeps delivery order stable for equal times.
+  IPAddress src;
+  IPAddress dst;
+  std::vector<uint8_t> data;
+};
+
+struct NodeStats {
+  unsigned long packets_sent;
+  unsigned long bytes_sent;
+  unsigned long packets_received;
+  unsigned long bytes_received;
+  unsigned long loop_calls;
+  unsigned long long cpu_ns;   // Thread CPU time spent in the node's loop.
+};
+
+class Node {
+ public:
+  explicit Node(const IPAddress& ip) : ip(ip), stats(), wake_at(0), slept_ms(0) {}
+
+  const IPAddress ip;
+
+  // Called whenever the node has a packet waiting or its deadline is reached.
+  // Must call MDns::loop() once per waiting packet it wants to process.
+  std::function<void()> loop;
+
+  // millis() time the node next needs its loop run, eg: MDns::nextDeadlineMillis().
+  std::function<unsigned long()> next_deadline;
+
+  NodeStats stats;
+
+ private:
+  friend class Network;
+  friend class ::WiFiUDP;
+  friend void ::delay(unsigned long ms);
+
+  bool PacketDue(unsigned long now) const;
+
+  std::vector<Datagram> inbox;   // Min-heap on (deliver_at, sequence).
+  Datagram rx;                   // Packet returned by the last parsePacket().
+  size_t rx_pos;
+  Datagram tx;                   // Packet being built between beginPacket() and endPacket().
+  unsigned long wake_at;
+  unsigned long slept_ms;        // delay() time during the current run.
+};
+
+class Network {
+ public:
+  // Args:
+  //   seed : Seeds packet loss, latency jitter and the Arduino random().
+  explicit Network(unsigned long seed);
+  ~Network();
+
+  // Fraction of deliveries dropped, from 0.0 to 1.0. Applied per receiver.
+  double loss;
+  // Delivery latency is latency_ms plus up to jitter_ms.
+  unsigned long latency_ms;
+  unsigned long jitter_ms;
+
+  Node& AddNode(const IPAddress& ip);
+  std::vector<std::unique_ptr<Node> >& nodes() { return nodes_; }
+
+  // Run nodes until virtual time end_ms.
+  void RunUntil(unsigned long end_ms);
+
+  // Run fn as if on node, so WiFi, WiFiUDP and millis() act for that node.
+  // CPU time is charged to the node.
+  void RunOnNode(Node& node, const std::function<void()>& fn);
+
+  unsigned long now() const { return now_; }
+
+  // millis() as seen by the running node: now() plus any delay() it has done
+  // during this run.
+  unsigned long local_now() const { return current_ ? now_ + current_->slept_ms : now_; }
+
+  // The Network whose virtual clock and nodes the host stand-ins use.
+  static Network* active() { return active_; }
+  // The node whose loop is running, or NULL.
+  Node* current() const { return current_; }
+
+  // Totals over the whole bus.
+  unsigned long packets_on_bus;
+  unsigned long bytes_on_bus;
+  unsigned long query_packets;
+  unsigned long response_packets;
+  unsigned long deliveries;
+  unsigned long dropped;
+  // Most packets put on the bus in any one second of virtual time.
+  unsigned long peak_packets_per_second;
+
+ private:
+  friend class ::WiFiUDP;
+  friend void ::delay(unsigned long ms);
+
+  void Transmit(Node& sender);
+  void Deliver(Node& receiver, const Datagram& datagram);
+
+  std::vector<std::unique_ptr<Node> > nodes_;
+  std::mt19937 generator_;
+  unsigned long now_;
+  unsigned long sequence_;
+  unsigned long second_start_;
+  unsigned long second_packets_;
+  Node* current_;
+
+  static Network* active_;
+};
+
+}  // namespace sim
+
+#endif  // SIMULATOR_NETWORK_H
@@ -0,0 +1,285 @@
+// Runs N MDns nodes on one simulated network segment and reports the traffic
+// and CPU time they generate.
+//
+// Every node owns an A record for nodeN.local, which the library answers
+// automatically. Every --query-interval ms each node queries the name of a
+// random peer, so query and response traffic both scale with node count.
+
+#include <mdns.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "file_print.h"
+#include "network.h"
+
+namespace {
+
+struct Options {
+  std::vector<unsigned int> node_counts;
+  unsigned long duration_ms;
+  unsigned long query_interval_ms;
+  double loss;
+  unsigned long latency_ms;
+  unsigned long jitter_ms;
+  unsigned long seed;
+  bool per_node;
+  const char* pcap_path;
+  bool use_resolve;
+};
+
+// Datagrams kept by the --pcap capture.
+#define PCAP_SLOTS 256
+
+// One simulated device: its MDns instance, the record it owns and its
+// application state.
+struct Device {
+  Device() : mdns(NULL, NULL, NULL), next_query_at(0) {}
+
+  mdns::MDns mdns;
+  mdns::BasicResolver<> resolver;
+  mdns::Answer a_record;
+  unsigned long next_query_at;
+};
+
+// Outcome of --resolve lookups.
+struct ResolveStats {
+  unsigned long resolved;
+  unsigned long failed;
+  unsigned long wrong;
+};
+
+IPAddress NodeAddress(unsigned int index) {
+  return IPAddress(10, (index >> 16) & 0xFF, (index >> 8) & 0xFF, index & 0xFF);
+}
+
+void NodeName(unsigned int index, char* name_buffer) {
+  sprintf(name_buffer, "node%u.local", index);
+}
+
+void RunScenario(const Options& options, unsigned int node_count) {
+  sim::Network network(options.seed);
+  network.loss = options.loss;
+  network.latency_ms = options.latency_ms;
+  network.jitter_ms = options.jitter_ms;
+
+  ResolveStats resolve_stats = ResolveStats();
+  std::vector<std::unique_ptr<Device> > devices;
+  for (unsigned int i = 0; i < node_count; ++i) {
+    devices.push_back(std::unique_ptr<Device>(new Device));
+    Device& device = *devices.back();
+    sim::Node& node = network.AddNode(NodeAddress(i + 1));
+
+    mdns::Answer& record = device.a_record;
+    NodeName(i, record.name_buffer);
+    record.rrtype = MDNS_TYPE_A;
+    record.rrclass = 1;
+    record.rrttl = 120;
+    record.rrset = true;
+    for (int b = 0; b < 4; ++b) {
+      record.rdata_buffer[b] = node.ip[b];
+    }
+    device.mdns.AddOwnedRecord(&record);
+    if (options.use_resolve) {
+      device.mdns.setResolver(&device.resolver);
+    }
+    device.next_query_at = random(options.query_interval_ms);
+    network.RunOnNode(node, [&device]() { device.mdns.begin(); });
+
+    node.loop = [&device, &options, &resolve_stats, node_count, i]() {
+      if ((long)(millis() - device.next_query_at) >= 0 && node_count > 1) {
+        unsigned int peer = random(node_count - 1);
+        if (peer >= i) {
+          peer++;
+        }
+        mdns::Query query;
+        NodeName(peer, query.qname_buffer);
+        if (options.use_resolve) {
+          const IPAddress expected = NodeAddress(peer + 1);
+          device.mdns.resolve(query.qname_buffer,
+              [&resolve_stats, expected](const char* name, IPAddress address) {
+                (void)name;
+                if (address == IPAddress(0, 0, 0, 0)) {
+                  resolve_stats.failed++;
+                } else if (address == expected) {
+                  resolve_stats.resolved++;
+                } else {
+                  resolve_stats.wrong++;
+                }
+              }, 5000);
+        } else {
+          query.qtype = MDNS_TYPE_A;
+          query.qclass = 1;
+          query.unicast_response = false;
+          device.mdns.Clear();
+          device.mdns.AddQuery(query);
+          device.mdns.Send();
+        }
+        device.next_query_at += options.query_interval_ms;
+      }
+      device.mdns.loop();
+    };
+    node.next_deadline = [&device]() {
+      const unsigned long deadline = device.mdns.nextDeadlineMillis();
+      if ((long)(device.next_query_at - deadline) < 0) {
+        return device.next_query_at;
+      }
+      return deadline;
+    };
+  }
+
+  // Node 0's traffic for --pcap.
+  std::unique_ptr<mdns::BasicPacketCapture<PCAP_SLOTS, MAX_PACKET_SIZE> > capture;
+  if (options.pcap_path) {
+    capture.reset(new mdns::BasicPacketCapture<PCAP_SLOTS, MAX_PACKET_SIZE>);
+    devices.front()->mdns.setCapture(capture.get());
+  }
+
+  network.RunUntil(options.duration_ms);
+
+  if (capture) {
+    // One file per node count: path.N
+    const std::string path = std::string(options.pcap_path) + "." + std::to_string(node_count);
+    FILE* file = fopen(path.c_str(), "wb");
+    if (file) {
+      sim::FilePrint out(file);
+      capture->WritePcap(out);
+      fclose(file);
+    } else {
+      perror(path.c_str());
+    }
+  }
+
+  unsigned long long cpu_total = 0, cpu_min = ~0ULL, cpu_max = 0;
+  for (auto& node : network.nodes()) {
+    cpu_total += node->stats.cpu_ns;
+    cpu_min = std::min(cpu_min, node->stats.cpu_ns);
+    cpu_max = std::max(cpu_max, node->stats.cpu_ns);
+  }
+  const double seconds = options.duration_ms / 1000.0;
+
+  printf("%6u %9lu %11lu %9lu %9lu %9.1f %9lu %9lu %9.1f %9.1f %9.1f\n",
+         node_count, network.packets_on_bus, network.bytes_on_bus,
+         network.query_packets, network.response_packets,
+         network.packets_on_bus / seconds, network.peak_packets_per_second,
+         network.dropped, cpu_min / 1000.0, (double)cpu_total / node_count / 1000.0,
+         cpu_max / 1000.0);
+
+  if (options.use_resolve) {
+    printf("  resolve(): %lu resolved, %lu timed out, %lu wrong address\n",
+           resolve_stats.resolved, resolve_stats.failed, resolve_stats.wrong);
+  }
+
+  if (options.per_node) {
+    printf("  %-12s %8s %10s %8s %10s %8s %10s\n", "node", "tx_pkts", "tx_bytes",
+           "rx_pkts", "rx_bytes", "loops", "cpu_us");
+    for (auto& node : network.nodes()) {
+      char ip[16];
+      sprintf(ip, "%u.%u.%u.%u", node->ip[0], node->ip[1], node->ip[2], node->ip[3]);
+      printf("  %-12s %8lu %10lu %8lu %10lu %8lu %10.1f\n", ip, node->stats.packets_sent,
+             node->stats.bytes_sent, node->stats.packets_received, node->stats.bytes_received,
+             node->stats.loop_calls, node->stats.cpu_ns / 1000.0);
+    }
+  }
+}
+
+void Usage(const char* program) {
+  fprintf(stderr,
+          "Usage: %s [options]\n"
+          "  --nodes N[,N...]       Node counts to simulate. (Default 10,50,100,200)\n"
+          "  --duration MS          Virtual time to run each simulation for. (Default 60000)\n"
+          "  --query-interval MS    Time between each node's queries. (Default 10000)\n"
+          "  --loss FRACTION        Fraction of deliveries dropped. (Default 0)\n"
+          "  --latency MS           Delivery latency. (Default 1)\n"
+          "  --jitter MS            Extra random delivery latency. (Default 0)\n"
+          "  --seed N               Random seed. (Default 1)\n"
+          "  --per-node             Print statistics for every node.\n"
+          "  --resolve              Look peers up with MDns::resolve() rather than raw queries.\n"
+          "  --pcap PATH            Save node 0's last %u packets to PATH.<nodes>.\n",
+          program, PCAP_SLOTS);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  options.duration_ms = 60000;
+  options.query_interval_ms = 10000;
+  options.loss = 0.0;
+  options.latency_ms = 1;
+  options.jitter_ms = 0;
+  options.seed = 1;
+  options.per_node = false;
+  options.pcap_path = NULL;
+  options.use_resolve = false;
+
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+    if (arg == "--per-node") {
+      options.per_node = true;
+      continue;
+    }
+    if (arg == "--resolve") {
+      options.use_resolve = true;
+      continue;
+    }
+    if (!value) {
+      Usage(argv[0]);
+      return 1;
+    }
+    ++i;
+    if (arg == "--nodes") {
+      for (const char* p = value; *p; ) {
+        options.node_counts.push_back(strtoul(p, (char**)&p, 10));
+        if (*p == ',') {
+          ++p;
+        } else if (*p) {
+          Usage(argv[0]);
+          return 1;
+        }
+      }
+    } else if (arg == "--duration") {
+      options.duration_ms = strtoul(value, NULL, 10);
+    } else if (arg == "--query-interval") {
+      options.query_interval_ms = strtoul(value, NULL, 10);
+    } else if (arg == "--loss") {
+      options.loss = atof(value);
+    } else if (arg == "--latency") {
+      options.latency_ms = strtoul(value, NULL, 10);
+    } else if (arg == "--jitter") {
+      options.jitter_ms = strtoul(value, NULL, 10);
+    } else if (arg == "--pcap") {
+      options.pcap_path = value;
+    } else if (arg == "--seed") {
+      options.seed = strtoul(value, NULL, 10);
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (options.node_counts.empty()) {
+    options.node_counts = {10, 50, 100, 200};
+  }
+  if (options.query_interval_ms == 0) {
+    options.query_interval_ms = 1;
+  }
+
+  printf("duration %lu ms, query interval %lu ms, loss %.3f, latency %lu+%lu ms, seed %lu\n",
+         options.duration_ms, options.query_interval_ms, options.loss, options.latency_ms,
+         options.jitter_ms, options.seed);
+  printf("%6s %9s %11s %9s %9s %9s %9s %9s %9s %9s %9s\n", "nodes", "packets", "bytes",
+         "queries", "responses", "pkts/s", "peak/s", "dropped", "cpu_min", "cpu_avg",
+         "cpu_max");
+  for (unsigned int node_count : options.node_counts) {
+    RunScenario(options, node_count);
+  }
+  printf("cpu_* columns are microseconds of thread CPU time per node.\n");
+  return 0;
+}
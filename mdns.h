@@ -5,6 +5,11 @@
 #include <ESP8266WiFi.h>
 #include <WiFiUdp.h>
 
+#include <algorithm>
+
+#include "mdns_capture.h"
+#include "mdns_queue.h"
+
 #define DEBUG_STATISTICS      // Record how many incoming packets fitted into data_buffer.
 //#define DEBUG_OUTPUT          // Send packet summaries to Serial.
 //#define DEBUG_RAW             // Send HEX ans ASCII encoded raw packet to Serial.
@@ -16,6 +21,8 @@
 #define MDNS_TYPE_TXT   0x0010
 #define MDNS_TYPE_AAAA  0x001C
 #define MDNS_TYPE_SRV   0x0021
+#define MDNS_TYPE_NSEC  0x002F
+#define MDNS_TYPE_ANY   0x00FF
 
 #define MDNS_TARGET_PORT 5353
 #define MDNS_SOURCE_PORT 5353
@@ -23,35 +30,95 @@
 
 // Make this as big as memory limitations allow.
 // This default value can be overridden using the max_packet_size_ parameter of
-// MDns().
+// MDns() or at compile time with the PacketSize parameter of BasicMDns<>.
 #define MAX_PACKET_SIZE 1024
 
 // The mDNS spec says this should never be more than 256 (including trailing '\0').
+// Constrained builds can use a smaller NameLen parameter of BasicMDns<>.
 #define MAX_MDNS_NAME_LEN 256  
 
+// When nothing is scheduled, nextDeadlineMillis() is this far in the future so
+// incoming packets still get processed by a sleeping sketch.
+#define MDNS_MAX_IDLE_MILLIS 1000
+
+// How often loop(timeout_ms) checks for an incoming packet while waiting.
+#define MDNS_POLL_INTERVAL_MILLIS 10
+
+// How many different names resolve() can be looking up at once.
+#define MAX_MDNS_PENDING_RESOLVES 4
+
+// How many resolve() callbacks can be waiting on lookups in total.
+#define MAX_MDNS_RESOLVE_CALLBACKS 8
+
+// How many addresses found by resolve() are remembered.
+#define MAX_MDNS_RESOLVE_CACHE 4
+
+// Delay before resolve() repeats an unanswered query. Doubles after each retry.
+// (RFC 6762 section 5.2.)
+#define MDNS_RESOLVE_RETRY_MILLIS 1000
+
+// Longest time a resolved address is cached, whatever its TTL.
+#define MDNS_RESOLVE_MAX_TTL 3600
+
+// How many records this device can be authoritative for. See AddOwnedRecord().
+// Each costs about 50 bytes, mostly its name's NSEC bitmap, in every MDns, so
+// builds that never own records can set this to 0. At most 31.
+#ifndef MAX_MDNS_OWNED_RECORDS
+#define MAX_MDNS_OWNED_RECORDS 8
+#endif
+
+// Probing and announcing owned records. (RFC 6762 sections 8.1 and 8.3.)
+// The first probe is sent after a random delay of up to MDNS_PROBE_MAX_DELAY_MILLIS.
+#define MDNS_PROBE_MAX_DELAY_MILLIS 250
+#define MDNS_PROBE_COUNT 3
+#define MDNS_PROBE_INTERVAL_MILLIS 250
+#define MDNS_ANNOUNCE_COUNT 2
+#define MDNS_ANNOUNCE_INTERVAL_MILLIS 1000
+
+// Incoming packets identical to one of the last MDNS_DUPLICATE_FILTER_SIZE
+// packets from the same source within MDNS_DUPLICATE_WINDOW_MILLIS are dropped
+// before parsing. eg: The same response arriving over several interfaces.
+// Fingerprints are forgotten whenever AddQuery() is called.
+// Set MDNS_DUPLICATE_FILTER_SIZE to 0, eg: with -DMDNS_DUPLICATE_FILTER_SIZE=0, to disable.
+#ifndef MDNS_DUPLICATE_FILTER_SIZE
+#define MDNS_DUPLICATE_FILTER_SIZE 8
+#endif
+#ifndef MDNS_DUPLICATE_WINDOW_MILLIS
+#define MDNS_DUPLICATE_WINDOW_MILLIS 1000
+#endif
+
+#define MDNS_FNV_OFFSET_BASIS 2166136261UL
+
+// Uses the MAX_MDNS_* and MDNS_RESOLVE_* settings above.
+#include "mdns_resolver.h"
+
 namespace mdns{
 
 // A single mDNS Query.
-typedef struct Query{
+// NameLen is the size of qname_buffer, including trailing '\0'.
+template <unsigned int NameLen>
+struct BasicQuery{
 #ifdef DEBUG_OUTPUT
   unsigned int buffer_pointer;            // Position of Answer in packet. (Used for debugging only.)
 #endif
-  char qname_buffer[MAX_MDNS_NAME_LEN];   // Question Name: Contains the object, domain or zone name.
+  char qname_buffer[NameLen];             // Question Name: Contains the object, domain or zone name.
   unsigned int qtype;                     // Question Type: Type of question being asked by client.
   unsigned int qclass;                    // Question Class: Normally the value 1 for Internet (“IN”)
   bool unicast_response;                  // 
   bool valid;                             // False if problems were encountered decoding packet.
 
   void Display() const;                   // Display a summary of this Answer on Serial port.
-} Query;
+};
 
 // A single mDNS Answer.
-typedef struct Answer{
+// NameLen is the size of name_buffer and rdata_buffer, including trailing '\0'.
+template <unsigned int NameLen>
+struct BasicAnswer{
 #ifdef DEBUG_OUTPUT
   unsigned int buffer_pointer;          // Position of Answer in packet. (Used for debugging only.)
 #endif
-  char name_buffer[MAX_MDNS_NAME_LEN];  // object, domain or zone name.
-  char rdata_buffer[MAX_MDNS_NAME_LEN]; // The data portion of the resource record.
+  char name_buffer[NameLen];            // object, domain or zone name.
+  char rdata_buffer[NameLen];           // The data portion of the resource record.
   unsigned int rrtype;                  // ResourceRecord Type.
   unsigned int rrclass;                 // ResourceRecord Class: Normally the value 1 for Internet (“IN”)
   unsigned long int rrttl;              // ResourceRecord Time To Live: Number of seconds ths should be remembered.
@@ -59,29 +126,81 @@ typedef struct Answer{
   bool valid;                           // False if problems were encountered decoding packet.
 
   void Display() const ;                // Display a summary of this Answer on Serial port.
-} Answer;
+};
+
+// Sections of an mDNS packet, in the order they appear.
+enum Section {
+  QUESTION_SECTION,
+  ANSWER_SECTION,
+  AUTHORITY_SECTION,    // Proposed records in probe Queries. (RFC 6762 section 8.2.)
+  ADDITIONAL_SECTION    // Records the receiver is likely to ask for next.
+};
+
+// Query and Answer sized for the default MDns.
+// Real types rather than typedefs so "struct mdns::Query" still compiles.
+struct Query : BasicQuery<MAX_MDNS_NAME_LEN> {};
+struct Answer : BasicAnswer<MAX_MDNS_NAME_LEN> {};
+
+// Query and Answer types for a given NameLen.
+// The default NameLen uses mdns::Query and mdns::Answer so callbacks written
+// for those work with any MDns that has full length names.
+template <unsigned int NameLen>
+struct RecordTypes {
+  typedef BasicQuery<NameLen> Query;
+  typedef BasicAnswer<NameLen> Answer;
+};
 
-class MDns {
+template <>
+struct RecordTypes<MAX_MDNS_NAME_LEN> {
+  typedef mdns::Query Query;
+  typedef mdns::Answer Answer;
+};
+
+// A UDP instance to let us send and receive packets over UDP.
+extern WiFiUDP Udp;
+
+// mDNS packet handler with compile-time buffer sizes.
+// Args:
+//   PacketSize : Size of data_buffer embedded in the object, so no heap is used.
+//                If 0, data_buffer is allocated on the heap at construction or
+//                supplied by the caller.
+//   NameLen : Size of the name buffers in Query and Answer.
+// eg: mdns::BasicMDns<512, 64> my_mdns(NULL, NULL, answerCallback);
+template <unsigned int PacketSize, unsigned int NameLen>
+class BasicMDns {
  private:
  public:
+  // Query and Answer records sized to match this MDns.
+  typedef typename RecordTypes<NameLen>::Query Query;
+  typedef typename RecordTypes<NameLen>::Answer Answer;
+
+  // Called by resolve() with the address found for name.
+  // address is 0.0.0.0 if the lookup timed out.
+  typedef mdns::ResolveCallback ResolveCallback;
+
+  // Called when another host is found to be using name while it is being probed.
+  typedef std::function<void(const char* name)> ConflictCallback;
+
   // Simple constructor does not fire any callbacks on incoming data.
   // Default incoming data_buffer size is used.
-  MDns() : MDns(NULL, NULL, NULL, MAX_PACKET_SIZE) {}
+  BasicMDns() : BasicMDns(NULL, NULL, NULL, PacketSize ? PacketSize : MAX_PACKET_SIZE) {}
 
   // Simple constructor does not fire any callbacks on incoming data.
   // Args:
   //   max_packet_size_ : Set the data_buffer size allocated to store incoming packets.
-  MDns(int max_packet_size_) : MDns(NULL, NULL, NULL, max_packet_size_) {}
+  //                      May not exceed PacketSize if that is non-zero.
+  BasicMDns(int max_packet_size_) : BasicMDns(NULL, NULL, NULL, max_packet_size_) {}
   
   // Constructor takes callbacks which fire when mDNS data arrives.
   // Args:
   //   p_packet_function : Callback fires for every mDNS packet that arrives.
   //   p_query_function : Callback fires for every mDNS Query that arrives as part of a packet.
   //   p_answer_function : Callback fires for every mDNS Answer that arrives as part of a packet.
-  MDns(std::function<void(const MDns*)> p_packet_function, 
-       std::function<void(const Query*)> p_query_function, 
-       std::function<void(const Answer*)> p_answer_function) :
-    MDns(p_packet_function, p_query_function, p_answer_function, MAX_PACKET_SIZE) { }
+  BasicMDns(std::function<void(const BasicMDns*)> p_packet_function, 
+            std::function<void(const Query*)> p_query_function, 
+            std::function<void(const Answer*)> p_answer_function) :
+    BasicMDns(p_packet_function, p_query_function, p_answer_function,
+              PacketSize ? PacketSize : MAX_PACKET_SIZE) { }
 
   // Constructor takes callbacks which fire when mDNS data arrives.
   // Args:
@@ -89,57 +208,94 @@ class MDns {
   //   p_query_function : Callback fires for every mDNS Query that arrives as part of a packet.
   //   p_answer_function : Callback fires for every mDNS Answer that arrives as part of a packet.
   //   max_packet_size_ : Set the data_buffer size allocated to store incoming packets.
-  MDns(std::function<void(const MDns*)> p_packet_function, 
-       std::function<void(const Query*)> p_query_function, 
-       std::function<void(const Answer*)> p_answer_function,
-       int max_packet_size_) :
+  //                      May not exceed PacketSize if that is non-zero.
+  BasicMDns(std::function<void(const BasicMDns*)> p_packet_function, 
+            std::function<void(const Query*)> p_query_function, 
+            std::function<void(const Answer*)> p_answer_function,
+            int max_packet_size_) :
 #ifdef DEBUG_STATISTICS
        buffer_size_fail(0),
        largest_packet_seen(0),
        packet_count(0),
+       duplicate_count(0),
 #endif
        p_packet_function_(p_packet_function),
        p_query_function_(p_query_function),
        p_answer_function_(p_answer_function),
        buffer_pointer(0),
-       data_buffer(new byte[max_packet_size_]),
-       max_packet_size(max_packet_size_)
+       data_buffer(PacketSize ? static_buffer : new byte[max_packet_size_]),
+       max_packet_size((PacketSize && (unsigned int)max_packet_size_ > PacketSize) ?
+                       PacketSize : max_packet_size_),
+       owns_data_buffer(!PacketSize),
+       capture(NULL),
+       receive_queue(NULL),
+       owned_record_count(0),
+       owned_name_count(0),
+       resolver(NULL),
+       probe_step(MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT),
+       probed(false),
+       conflict(false),
+       recent_packet_count(0),
+       recent_packet_next(0)
        { 
        };
 
   // Constructor can be passed the buffer to hold the mDNS data.
   // This way the potentially large buffer can be shared with other processes.
+  // Use PacketSize of 0 with this constructor or the embedded buffer is wasted.
   // Args:
   //   p_packet_function : Callback fires for every mDNS packet that arrives.
   //   p_query_function : Callback fires for every mDNS Query that arrives as part of a packet.
   //   p_answer_function : Callback fires for every mDNS Answer that arrives as part of a packet.
   //   max_packet_size_ : Set the data_buffer size allocated to store incoming packets.
-  MDns(std::function<void(const MDns*)> p_packet_function, 
-       std::function<void(const Query*)> p_query_function,
-       std::function<void(const Answer*)> p_answer_function,
-       byte* data_buffer_,
-       int max_packet_size_) :
+  BasicMDns(std::function<void(const BasicMDns*)> p_packet_function, 
+            std::function<void(const Query*)> p_query_function,
+            std::function<void(const Answer*)> p_answer_function,
+            byte* data_buffer_,
+            int max_packet_size_) :
 #ifdef DEBUG_STATISTICS
        buffer_size_fail(0),
        largest_packet_seen(0),
        packet_count(0),
+       duplicate_count(0),
 #endif
        p_packet_function_(p_packet_function),
        p_query_function_(p_query_function),
        p_answer_function_(p_answer_function),
        buffer_pointer(0),
        data_buffer(data_buffer_),
-       max_packet_size(max_packet_size_)
+       max_packet_size(max_packet_size_),
+       owns_data_buffer(false),
+       capture(NULL),
+       receive_queue(NULL),
+       owned_record_count(0),
+       owned_name_count(0),
+       resolver(NULL),
+       probe_step(MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT),
+       probed(false),
+       conflict(false),
+       recent_packet_count(0),
+       recent_packet_next(0)
        { 
        };
 
-  ~MDns();
+  ~BasicMDns();
 
 // added to call startUdpMulticast
+// Also starts probe() if any records have been registered with AddOwnedRecord().
 void begin();
 
   // Call this regularly to check for an incoming packet.
   bool loop();
+
+  // Wait for up to timeout_ms for an incoming packet and process it.
+  // Work that falls due while waiting, eg: resolve() retries, is done as well.
+  // Waiting is done with delay() so the ESP8266 can sleep between checks.
+  bool loop(const unsigned long timeout_ms);
+
+  // millis() value by which loop() next needs to be called.
+  // Sketches can sleep until then rather than calling loop() in a busy loop.
+  unsigned long nextDeadlineMillis() const;
   // Deprecated. Use loop() instead.
   bool Check(){
     return loop();
@@ -151,16 +307,119 @@ void begin();
   // Send this MDns packet to a unicast address
   void SendUnicast(IPAddress) const;
 
+  // Send records as multicast responses, packing as many into each packet as
+  // fit in max_packet_size. Packets are sent back to back from data_buffer, so
+  // any packet being built is discarded.
+  // Returns false if any record could not be encoded, see CanEncode(), or did
+  // not fit even in an empty packet. Such records are skipped.
+  // eg: const mdns::Answer* records[] = {&ptr, &srv, &txt, &a};
+  //     my_mdns.SendRecords(records, 4);
+  bool SendRecords(const Answer* const* records, const unsigned int record_count,
+                   const Section section = ANSWER_SECTION);
+
+  // Send queries and a list of known answers, split across as many packets as
+  // needed. Every packet but the last has the TC bit set so responders wait for
+  // the rest of the known answers. (RFC 6762 section 7.2.)
+  // Returns false if any query or record did not fit even in an empty packet,
+  // or any record could not be encoded. Such queries and records are skipped.
+  bool SendQueries(const Query* const* queries, const unsigned int query_count_,
+                   const Answer* const* known_answers, const unsigned int known_answer_count);
+
   // Resets everything to represent an empty packet.
   // Do this before building a packet for sending.
   void Clear();
 
   // Add a query to packet prior to sending.
-  // May only be done before any Answers have been added.
+  // Marks the packet as a Query.
   bool AddQuery(const Query& query);
 
   // Add an answer to packet prior to sending.
+  // Marks the packet as an Answer unless it has Queries, when the answer is a
+  // known answer.
   bool AddAnswer(const Answer& answer);
+
+  // Add a resource record to any section of the packet prior to sending.
+  // Queries and records may be added in any order; each is placed at the end of
+  // its section and the header counts are updated. The packet is a Query if it
+  // has any Queries and a response otherwise.
+  // eg: A PTR answer with the SRV, TXT and A records in ADDITIONAL_SECTION, or a
+  // probe Query with the proposed records in AUTHORITY_SECTION.
+  // Supported rrtypes are A (4 bytes of address in rdata_buffer), PTR, TXT (length
+  // prefixed strings) and SRV ("p=0;w=0;port=80;host=name.local").
+  // Returns false, leaving the packet unchanged, if the record does not fit or
+  // CanEncode() is false for it.
+  bool AddRecord(const Answer& record, const Section section);
+
+  // True if AddRecord() supports record's rrtype and rdata_buffer is well formed.
+  // When this is true, AddRecord() only fails if the record does not fit.
+  bool CanEncode(const Answer& record) const;
+
+  // Add the NSEC record for a name registered with AddOwnedRecord() to the
+  // Additional section. Use when building a positive response by hand so the
+  // receiver knows no other record types exist for the name.
+  // Returns false unless the name has unique owned records. See AddOwnedRecord().
+  bool AddNsec(const char* name);
+
+  // Register a record this device is authoritative for.
+  // Queries for the record's name are then answered from loop(): with the
+  // matching records plus an NSEC record in the Additional section, or with
+  // only the NSEC record when none of the owned types match. (RFC 6762 section 6.1.)
+  // NSEC records are only sent for names with unique records.
+  // Records the Query already lists as known answers, with at least half their
+  // TTL left, are left out. (RFC 6762 section 7.1.)
+  // The record is not copied so must remain valid while registered.
+  // rdata_buffer holds the data in the form AddAnswer() expects.
+  // Only A, PTR, TXT and SRV records, which AddRecord() can send, can be owned.
+  // Set rrset (the cache-flush bit) on records unique to this device, eg: its A
+  // and SRV records. Only unique records are probed and checked for conflicts.
+  // Leave it clear on shared records, eg: a PTR from "_http._tcp.local" to this
+  // device's instance, which other devices may own too.
+  // Records are not used to answer queries until they have been probed. Adding
+  // one after begin() restarts probe() so the new record is probed too.
+  // Returns false if CanEncode() is false for the record or when
+  // MAX_MDNS_OWNED_RECORDS are registered.
+  bool AddOwnedRecord(const Answer* record);
+
+  // Forget all records registered with AddOwnedRecord().
+  void ClearOwnedRecords();
+
+  // Claim the owned names on the network without blocking.
+  // loop() sends MDNS_PROBE_COUNT probes asking for every name with unique owned
+  // records, with those records in the Authority section, then announces all the
+  // owned records MDNS_ANNOUNCE_COUNT times. Records are packed into as few
+  // packets as fit. With only shared records, announcing starts straight away.
+  // Owned records are not used to answer queries until probing has finished.
+  // If another host answers for a name with unique owned records while probing,
+  // probing stops, queries are no longer answered and the conflict callback
+  // fires. Rename the records and call probe() again.
+  // Simultaneous probe tie-breaking (RFC 6762 section 8.2) is not done.
+  // begin() calls this, so there is usually no need to call it directly.
+  void probe();
+
+  // True from probe() until the owned records are first announced.
+  bool probing() const;
+
+  // True once probing has found a conflict, until probe() is called again.
+  // Owned records are not used to answer queries meanwhile.
+  bool conflicted() const;
+
+  // Set the function called when probing finds a conflict. Pass NULL to remove it.
+  void setConflictCallback(ConflictCallback callback);
+
+  // Keep resolve() lookups in resolver. Pass NULL to stop resolving names.
+  // The MDns does not take ownership of resolver.
+  void setResolver(Resolver* resolver_);
+
+  // Look up the IPv4 address of name, eg: "broker.local", without blocking.
+  // If the address is cached, callback fires before resolve() returns.
+  // Otherwise an A query is sent from the next loop() and repeated until an
+  // answer arrives or timeout_ms passes, and callback fires from loop().
+  // Concurrent lookups for the same name share one query, and each callback
+  // still fails after its own timeout_ms.
+  // Answers are cached for their TTL.
+  // Returns false if there is no room to track the lookup or no resolver has
+  // been set with setResolver().
+  bool resolve(const char* name, ResolveCallback callback, const unsigned long timeout_ms);
   
   // Display a summary of the packet on Serial port.
   void Display() const;
@@ -168,6 +427,16 @@ void begin();
   // Display the raw packet in HEX and ASCII.
   void DisplayRawPacket() const;
 
+  // Record every packet sent and received in capture.
+  // Pass NULL to stop recording.
+  void setCapture(PacketCapture* capture_);
+
+  // Have loop() take incoming packets from receive_queue rather than polling Udp.
+  // Whatever fills the queue must listen for packets itself, so begin() no
+  // longer joins the multicast group. Call this before begin().
+  // Pass NULL to go back to polling Udp.
+  void setReceiveQueue(PacketQueue* receive_queue_);
+
   // Get the source IP address of the packet
   IPAddress getRemoteIP();
 
@@ -185,18 +454,49 @@ void begin();
 
   // How many mDNS packets have arrived so far.
   unsigned int packet_count;
+
+  // How many of packet_count were dropped as duplicates without being parsed.
+  unsigned int duplicate_count;
 #endif
  private:
+  // data_buffer may point at static_buffer so copies would share it.
+  BasicMDns(const BasicMDns&) = delete;
+  BasicMDns& operator=(const BasicMDns&) = delete;
+
   // Initializes udp multicast
   void startUdpMulticast();
 
+  void RunTimers();
+  void SendResolveQueries();
+  void ResolveAnswer(const Answer& answer);
+  unsigned int ReadPacket();
+  bool Parse_Packet(const unsigned int packet_size);
+  bool IsDuplicate();
   void Parse_Query(Query& query);
   void Parse_Answer(Answer& answer);
   unsigned int PopulateName(const char* name_buffer);
   void PopulateAnswerResult(Answer* answer);
+  int FindOwnedName(const char* name) const;
+  bool HasUniqueRecord(const unsigned int name_index) const;
+  bool IsConflict(const Answer& answer) const;
+  bool SameRdata(const Answer& answer, const Answer& record) const;
+  bool PopulateRecordHeader(const char* name, const unsigned int rrtype,
+                            const unsigned int rrclass, const unsigned long int rrttl);
+  void CommitRecord(const Section section);
+  bool AddNsecRecord(const unsigned int name_index, const Section section);
+  // add is any functor returning bool. Not a std::function, which may use the heap.
+  template <typename Add>
+  bool AddOrSplit(const Add& add, const bool query, const IPAddress* unicast);
+  void SendSplitPacket(const bool query, const bool more_follows, const IPAddress* unicast);
+  void QueueResponse(const Query& query);
+  void SuppressKnownAnswer(const Answer& answer);
+  void SendResponse();
+  void SendProbe(const bool unicast_response);
+  void SendAnnouncement();
+  void RunProbe();
 
   // Pointer to function that gets called for every incoming mDNS packet.
-  std::function<void(const MDns*)> p_packet_function_;
+  std::function<void(const BasicMDns*)> p_packet_function_;
 
   // Pointer to function that gets called for every incoming query.
   std::function<void(const Query*)> p_query_function_;
@@ -213,6 +513,15 @@ void begin();
   // Buffer size for incoming MDns packet.
   unsigned int max_packet_size;
 
+  // True if data_buffer was allocated by the constructor and must be freed.
+  bool owns_data_buffer;
+
+  // Optional record of recent packets.
+  PacketCapture* capture;
+
+  // Optional source of incoming packets used instead of Udp.
+  PacketQueue* receive_queue;
+
   // Size of mDNS packet.
   unsigned int data_size;
 
@@ -231,11 +540,77 @@ void begin();
   unsigned int ns_count;
   unsigned int ar_count;
 
+  // Offset in data_buffer of the end of each section while building a packet.
+  // The Additional section ends at data_size.
+  unsigned int section_end[ADDITIONAL_SECTION];
+
   // source & destination IP for incoming UDP packet
   IPAddress srcIP;
   IPAddress destIP;
+
+  // A name this device owns records for.
+  struct OwnedName {
+    const char* name;
+    unsigned long int ttl;
+    // Precomputed NSEC type bitmap: Window block 0, bitmap length, bitmap.
+    byte nsec_bitmap[34];
+  };
+
+  // Records registered with AddOwnedRecord().
+  // pending_records and pending_*_names hold a bit for each.
+  static_assert(MAX_MDNS_OWNED_RECORDS <= 31, "MAX_MDNS_OWNED_RECORDS must be at most 31");
+  const Answer* owned_records[MAX_MDNS_OWNED_RECORDS ? MAX_MDNS_OWNED_RECORDS : 1];
+  // Index into owned_names for each of owned_records.
+  byte owned_record_name[MAX_MDNS_OWNED_RECORDS ? MAX_MDNS_OWNED_RECORDS : 1];
+  unsigned int owned_record_count;
+
+  // Distinct names among owned_records.
+  OwnedName owned_names[MAX_MDNS_OWNED_RECORDS ? MAX_MDNS_OWNED_RECORDS : 1];
+  unsigned int owned_name_count;
+
+  // Response collected while parsing incoming queries. Bit n refers to
+  // owned_records[n] or owned_names[n].
+  unsigned int pending_records;
+  unsigned int pending_positive_names;
+  unsigned int pending_negative_names;
+  bool pending_multicast;
+
+  // Lookups started by resolve(). May be NULL.
+  Resolver* resolver;
+
+  // Start and length of the current Answer's rdata in data_buffer.
+  unsigned int rdata_pointer;
+  unsigned int rdata_length;
+
+  // Probes sent so far followed by announcements sent so far.
+  // MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT when probe() is not running.
+  unsigned int probe_step;
+  // millis() when the next probe or announcement is due.
+  unsigned long int probe_next_at;
+  // False until probe() is first called. Owned records are not answered before.
+  bool probed;
+  // Set when probing finds a conflict. Cleared by probe().
+  bool conflict;
+  ConflictCallback conflict_callback;
+
+  // Fingerprints of recently received packets, used by IsDuplicate().
+  struct RecentPacket {
+    unsigned long int fingerprint;
+    unsigned long int received_at;     // millis() when the packet arrived.
+  };
+  RecentPacket recent_packets[MDNS_DUPLICATE_FILTER_SIZE ? MDNS_DUPLICATE_FILTER_SIZE : 1];
+  unsigned int recent_packet_count;
+  // Slot in recent_packets the next fingerprint replaces.
+  unsigned int recent_packet_next;
+
+  // Embedded data_buffer storage when PacketSize is non-zero.
+  byte static_buffer[PacketSize ? PacketSize : 1];
 };
 
+// MDns with data_buffer on the heap (or supplied by the caller) and full
+// length names.
+typedef BasicMDns<0, MAX_MDNS_NAME_LEN> MDns;
+
 
 // Display a byte on serial console in hexadecimal notation,
 // padding with leading zero if necisary to provide evenly tabulated display data.
@@ -248,6 +623,14 @@ int nameFromDnsPointer(char* p_name_buffer, int name_buffer_pos, const int name_
 int nameFromDnsPointer(char* p_name_buffer, int name_buffer_pos, const int name_buffer_len,
     const byte* p_packet_buffer, int packet_buffer_pos, const bool recurse);
 
+// Move *deadline earlier to candidate if candidate comes first.
+// Both are millis() values so may have wrapped.
+void earliestDeadline(unsigned long* deadline, const unsigned long candidate);
+
+// Fold len bytes of data into a 32 bit FNV-1a hash.
+// Start with hash set to MDNS_FNV_OFFSET_BASIS.
+unsigned long int fnv1a(unsigned long int hash, const byte* data, const unsigned int len);
+
 bool writeToBuffer(const byte value, char* p_name_buffer, int* p_name_buffer_pos, const int name_buffer_len);
 
 int parseText(char* data_buffer, const int data_buffer_len, int const data_len,
@@ -255,4 +638,6 @@ int parseText(char* data_buffer, const int data_buffer_len, int const data_len,
 
 } // namespace mdns
 
+#include "mdns_impl.h"
+
 #endif  // MDNS_H
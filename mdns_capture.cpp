@@ -0,0 +1,118 @@
+#include <Arduino.h>
+#include "mdns.h"
+
+
+namespace mdns {
+
+
+// pcap link type for packets starting with an IP header.
+#define PCAP_LINKTYPE_RAW 101
+
+// Size of the IPv4 and UDP headers put in front of each datagram.
+#define PCAP_IP_UDP_HEADER_LEN 28
+
+// pcap files are written little endian. Readers detect this from the magic number.
+static size_t writeLittleEndian(Print& out, const unsigned long int value, const int len) {
+  byte buffer[4];
+  for (int i = 0; i < len; ++i) {
+    buffer[i] = (value >> (8 * i)) & 0xFF;
+  }
+  return out.write(buffer, len);
+}
+
+PacketCapture::PacketCapture(CaptureSlot* slots_, byte* data_, unsigned int slot_count_,
+                             unsigned int slot_size_) :
+    slots(slots_),
+    data(data_),
+    slot_count(slot_count_),
+    slot_size(slot_size_),
+    next_slot(0),
+    used_slots(0) {
+}
+
+void PacketCapture::Record(const byte* packet, unsigned int packet_len, IPAddress src,
+                           IPAddress dst, byte direction, unsigned int orig_len) {
+  if (!slot_count) {
+    return;
+  }
+  CaptureSlot& slot = slots[next_slot];
+  slot.timestamp = millis();
+  for (int i = 0; i < 4; ++i) {
+    slot.src[i] = src[i];
+    slot.dst[i] = dst[i];
+  }
+  slot.orig_len = orig_len > packet_len ? orig_len : packet_len;
+  slot.len = packet_len > slot_size ? slot_size : packet_len;
+  slot.direction = direction;
+  memcpy(data + next_slot * slot_size, packet, slot.len);
+
+  next_slot = (next_slot + 1) % slot_count;
+  if (used_slots < slot_count) {
+    used_slots++;
+  }
+}
+
+void PacketCapture::Clear() {
+  next_slot = 0;
+  used_slots = 0;
+}
+
+unsigned int PacketCapture::count() const {
+  return used_slots;
+}
+
+size_t PacketCapture::WritePcap(Print& out) const {
+  size_t written = 0;
+
+  // Global header.
+  written += writeLittleEndian(out, 0xA1B2C3D4, 4);  // Magic number.
+  written += writeLittleEndian(out, 2, 2);           // Major version.
+  written += writeLittleEndian(out, 4, 2);           // Minor version.
+  written += writeLittleEndian(out, 0, 4);           // GMT offset.
+  written += writeLittleEndian(out, 0, 4);           // Timestamp accuracy.
+  written += writeLittleEndian(out, slot_size + PCAP_IP_UDP_HEADER_LEN, 4);  // Snapshot length.
+  written += writeLittleEndian(out, PCAP_LINKTYPE_RAW, 4);
+
+  for (unsigned int i = 0; i < used_slots; ++i) {
+    // Oldest first.
+    const unsigned int slot_index = (next_slot + slot_count - used_slots + i) % slot_count;
+    const CaptureSlot& slot = slots[slot_index];
+
+    // Record header.
+    written += writeLittleEndian(out, slot.timestamp / 1000, 4);
+    written += writeLittleEndian(out, (slot.timestamp % 1000) * 1000, 4);
+    written += writeLittleEndian(out, slot.len + PCAP_IP_UDP_HEADER_LEN, 4);
+    written += writeLittleEndian(out, slot.orig_len + PCAP_IP_UDP_HEADER_LEN, 4);
+
+    // IPv4 and UDP headers, in network byte order.
+    const unsigned int ip_len = slot.orig_len + PCAP_IP_UDP_HEADER_LEN;
+    const unsigned int udp_len = slot.orig_len + 8;
+    byte header[PCAP_IP_UDP_HEADER_LEN] = {
+      0x45, 0x00, (byte)(ip_len >> 8), (byte)(ip_len & 0xFF),  // Version, length.
+      0x00, 0x00, 0x00, 0x00,                                 // Identification, fragment.
+      MDNS_TTL, 0x11, 0x00, 0x00,                             // TTL, UDP, checksum.
+      slot.src[0], slot.src[1], slot.src[2], slot.src[3],
+      slot.dst[0], slot.dst[1], slot.dst[2], slot.dst[3],
+      (MDNS_SOURCE_PORT >> 8), (MDNS_SOURCE_PORT & 0xFF),
+      (MDNS_TARGET_PORT >> 8), (MDNS_TARGET_PORT & 0xFF),
+      (byte)(udp_len >> 8), (byte)(udp_len & 0xFF),
+      0x00, 0x00                                              // No UDP checksum.
+    };
+    unsigned long int checksum = 0;
+    for (int j = 0; j < 20; j += 2) {
+      checksum += (header[j] << 8) + header[j + 1];
+    }
+    while (checksum >> 16) {
+      checksum = (checksum & 0xFFFF) + (checksum >> 16);
+    }
+    checksum = ~checksum & 0xFFFF;
+    header[10] = checksum >> 8;
+    header[11] = checksum & 0xFF;
+
+    written += out.write(header, PCAP_IP_UDP_HEADER_LEN);
+    written += out.write(data + slot_index * slot_size, slot.len);
+  }
+  return written;
+}
+
+} // namespace mdns
@@ -0,0 +1,86 @@
+#ifndef MDNS_CAPTURE_H
+#define MDNS_CAPTURE_H
+
+#include <Arduino.h>
+
+// Direction of a captured datagram.
+#define MDNS_CAPTURE_RX 0
+#define MDNS_CAPTURE_TX 1
+
+namespace mdns{
+
+// Details of one datagram held by PacketCapture.
+struct CaptureSlot{
+  unsigned long int timestamp;   // millis() when the datagram was recorded.
+  byte src[4];                   // Source IP address.
+  byte dst[4];                   // Destination IP address.
+  unsigned int len;              // Bytes held. May be less than orig_len.
+  unsigned int orig_len;         // Size of the datagram on the wire.
+  byte direction;                // MDNS_CAPTURE_RX or MDNS_CAPTURE_TX.
+};
+
+// Ring of the most recent raw mDNS datagrams, kept for post-mortem debugging.
+// Recording a datagram is a copy, so unlike Display() and DisplayRawPacket()
+// it is cheap enough to leave on in production.
+// Attach to an MDns with setCapture(). Use BasicPacketCapture<> to have the
+// storage embedded in the object.
+class PacketCapture {
+ public:
+  // Args:
+  //   slots_ : Array of slot_count_ CaptureSlot.
+  //   data_ : Buffer of slot_count_ * slot_size_ bytes to hold datagram contents.
+  //   slot_count_ : How many datagrams to keep.
+  //   slot_size_ : Datagrams longer than this are truncated.
+  PacketCapture(CaptureSlot* slots_, byte* data_, unsigned int slot_count_,
+                unsigned int slot_size_);
+
+  // Copy a datagram into the ring, overwriting the oldest once full.
+  // orig_len is the size of the datagram on the wire if only its first
+  // packet_len bytes are available. 0 means the whole datagram is in packet.
+  void Record(const byte* packet, unsigned int packet_len, IPAddress src, IPAddress dst,
+              byte direction, unsigned int orig_len = 0);
+
+  // Forget all recorded datagrams.
+  void Clear();
+
+  // Number of datagrams held.
+  unsigned int count() const;
+
+  // Write the held datagrams, oldest first, as a pcap file.
+  // Each is wrapped in IPv4 and UDP headers for port 5353 so Wireshark decodes it
+  // as mDNS. Timestamps are millis() since boot.
+  // Returns the number of bytes written.
+  size_t WritePcap(Print& out) const;
+
+ private:
+  // BasicPacketCapture points slots and data at its own storage so copies would share it.
+  PacketCapture(const PacketCapture&) = delete;
+  PacketCapture& operator=(const PacketCapture&) = delete;
+
+  CaptureSlot* slots;
+  byte* data;
+  unsigned int slot_count;
+  unsigned int slot_size;
+
+  // Slot the next datagram is written to.
+  unsigned int next_slot;
+
+  // Number of slots holding datagrams.
+  unsigned int used_slots;
+};
+
+// PacketCapture with storage for Slots datagrams of up to SlotSize bytes
+// embedded in the object.
+template <unsigned int Slots, unsigned int SlotSize>
+class BasicPacketCapture : public PacketCapture {
+ public:
+  BasicPacketCapture() : PacketCapture(slot_storage, data_storage, Slots, SlotSize) {}
+
+ private:
+  CaptureSlot slot_storage[Slots];
+  byte data_storage[Slots * SlotSize];
+};
+
+} // namespace mdns
+
+#endif  // MDNS_CAPTURE_H
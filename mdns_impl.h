@@ -0,0 +1,1386 @@
+// Template definitions for mdns.h. Do not include this file directly.
+#ifndef MDNS_IMPL_H
+#define MDNS_IMPL_H
+
+
+namespace mdns {
+
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::startUdpMulticast(){
+#ifdef DEBUG_OUTPUT
+  Serial.println("Initializing Multicast.");
+#endif
+  Udp.beginMulticast(WiFi.localIP(), IPAddress(224, 0, 0, 251), MDNS_TARGET_PORT);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::begin() {
+#ifdef DEBUG_OUTPUT
+Serial.println("Called begin");
+#endif
+  if (!receive_queue) {
+    // With a receive queue, whatever fills the queue listens for packets instead.
+    this->startUdpMulticast();
+  }
+  if (owned_record_count) {
+    probe();
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::loop() {
+  RunTimers();
+  return Parse_Packet(ReadPacket());
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::loop(const unsigned long timeout_ms) {
+  const unsigned long start = millis();
+  unsigned int packet_size;
+  while (true) {
+    RunTimers();
+    packet_size = ReadPacket();
+    if (packet_size) {
+      break;
+    }
+    const unsigned long now = millis();
+    if (now - start >= timeout_ms) {
+      break;
+    }
+    // Wake in time for the next scheduled work and for the timeout.
+    long wait = MDNS_POLL_INTERVAL_MILLIS;
+    const long until_deadline = nextDeadlineMillis() - now;
+    if (until_deadline < wait) {
+      wait = until_deadline > 0 ? until_deadline : 0;
+    }
+    const long until_timeout = timeout_ms - (now - start);
+    if (until_timeout < wait) {
+      wait = until_timeout;
+    }
+    delay(wait);
+  }
+  return Parse_Packet(packet_size);
+}
+
+// Fetch the next waiting packet into data_buffer, from receive_queue if set,
+// otherwise from Udp. Packets longer than max_packet_size are truncated.
+// Returns the size of the packet on the wire, or 0 if none is waiting.
+template <unsigned int PacketSize, unsigned int NameLen>
+unsigned int BasicMDns<PacketSize, NameLen>::ReadPacket() {
+  unsigned int packet_size = 0;
+  if (receive_queue) {
+    data_size = receive_queue->Pop(data_buffer, max_packet_size, &srcIP, &destIP, &packet_size);
+    return data_size ? packet_size : 0;
+  }
+
+  packet_size = Udp.parsePacket();
+  data_size = packet_size > max_packet_size ? max_packet_size : packet_size;
+  if (data_size) {
+    // Save the source and destination IP before reading the packet into the buffer.
+    srcIP = Udp.remoteIP();
+    destIP = Udp.destinationIP();
+    Udp.read(data_buffer, data_size);
+  }
+  return packet_size;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+unsigned long BasicMDns<PacketSize, NameLen>::nextDeadlineMillis() const {
+  unsigned long deadline = millis() + MDNS_MAX_IDLE_MILLIS;
+  if (resolver) {
+    resolver->EarliestDeadline(&deadline);
+  }
+  if (probe_step < MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT) {
+    earliestDeadline(&deadline, probe_next_at);
+  }
+  return deadline;
+}
+
+// Do any work that has fallen due.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::RunTimers() {
+  if (resolver) {
+    resolver->RunTimers();
+    SendResolveQueries();
+  }
+  RunProbe();
+}
+
+// Parse the data_size bytes waiting to be read from Udp.
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::Parse_Packet(const unsigned int packet_size) {
+  if (capture && packet_size) {
+    // Short packets too, and with their size on the wire if truncated.
+    capture->Record(data_buffer, data_size, srcIP, destIP, MDNS_CAPTURE_RX, packet_size);
+  }
+  if ( data_size > 12) {
+    // We've received a packet which is long enough to contain useful data.
+    // ReadPacket() has already copied it into data_buffer.
+    pending_records = 0;
+    pending_positive_names = 0;
+    pending_negative_names = 0;
+    pending_multicast = false;
+
+#ifdef DEBUG_STATISTICS
+    if(packet_size > largest_packet_seen){
+      largest_packet_seen = packet_size;
+    }
+    if(packet_size > data_size) {
+      buffer_size_fail++;
+    }
+    packet_count++;
+#endif
+
+    if (IsDuplicate()) {
+#ifdef DEBUG_STATISTICS
+      duplicate_count++;
+#endif
+      return true;
+    }
+    // data_buffer[0] and data_buffer[1] contain the Query ID field which is unused in mDNS.
+
+    // data_buffer[2] and data_buffer[3] are DNS flags which are mostly unused in mDNS.
+    type = !(data_buffer[2] & 0b10000000);  // If it's not a query, it's an answer.
+    truncated = data_buffer[2] & 0b00000010;  // If it's truncated we can expect more data soon so we should wait for additional records before deciding whether to respond.
+    if (data_buffer[3] & 0b00001111) {
+      // Non zero Response code implies error.
+      return false;
+    }
+
+    // Number of incoming queries.
+    query_count = (data_buffer[4] << 8) + data_buffer[5];
+
+    // Number of incoming answers.
+    answer_count = (data_buffer[6] << 8) + data_buffer[7];
+
+    // Number of incoming Name Server resource records.
+    ns_count = (data_buffer[8] << 8) + data_buffer[9];
+
+    // Number of incoming Additional resource records.
+    ar_count = (data_buffer[10] << 8) + data_buffer[11];
+
+    if(p_packet_function_) {
+      // Since a callback function has been registered, execute it.
+      p_packet_function_(this);
+    }
+
+#ifdef DEBUG_OUTPUT
+    Display();
+#endif  // DEBUG_OUTPUT
+
+    // Start of Data section.
+    buffer_pointer = 12;
+
+    for (unsigned int i_question = 0; i_question < query_count; i_question++) {
+      Query query;
+      Parse_Query(query);
+      if (query.valid) {
+        if (p_query_function_) {
+          // Since a callback function has been registered, execute it.
+          p_query_function_(&query);
+        }
+        if (type && probed && !probing() && !conflict) {
+          QueueResponse(query);
+        }
+      }
+      if(buffer_pointer > data_size){
+        return false;
+      }
+#ifdef DEBUG_OUTPUT
+      query.Display();
+#endif  // DEBUG_OUTPUT
+    }
+
+    for (unsigned int i_answer = 0; i_answer < (answer_count + ns_count + ar_count); i_answer++) {
+      Answer answer;
+      Parse_Answer(answer);
+      if (answer.valid) {
+        if (p_answer_function_) {
+          // Since a callback function has been registered, execute it.
+          p_answer_function_(&answer);
+        }
+        // Only addresses another host is answering with, not the proposed
+        // records in a probe's Authority section or known answers in a Query.
+        const bool authority = i_answer >= answer_count && i_answer < answer_count + ns_count;
+        if (!type && !authority && answer.rrtype == MDNS_TYPE_A && rdata_length == 4) {
+          ResolveAnswer(answer);
+        }
+        if (type && i_answer < answer_count && pending_records) {
+          SuppressKnownAnswer(answer);
+        }
+        if (!type && i_answer < answer_count && probing() && IsConflict(answer)) {
+          // Another host already answers for a name we are probing.
+          // (RFC 6762 section 8.1.)
+          probe_step = MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT;
+          conflict = true;
+          if (conflict_callback) {
+            conflict_callback(answer.name_buffer);
+          }
+        }
+      }
+      if(buffer_pointer > data_size){
+        return false;
+      }
+#ifdef DEBUG_OUTPUT
+      answer.Display();
+#endif  // DEBUG_OUTPUT
+    }
+
+#ifdef DEBUG_RAW
+    DisplayRawPacket();
+#endif  // DEBUG_RAW
+
+    if (pending_records || pending_negative_names) {
+      // Parsing is finished so data_buffer can be re-used for the response.
+      SendResponse();
+    }
+
+    return true;
+  }
+  return true;  // Not enough data for a full packet to be waiting.
+}
+
+// Check the packet in data_buffer against the fingerprints of recent packets
+// and remember its fingerprint if it is new.
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::IsDuplicate() {
+#if MDNS_DUPLICATE_FILTER_SIZE
+  byte source[4] = {srcIP[0], srcIP[1], srcIP[2], srcIP[3]};
+  const unsigned long int fingerprint =
+      fnv1a(fnv1a(MDNS_FNV_OFFSET_BASIS, source, 4), data_buffer, data_size);
+  const unsigned long now = millis();
+
+  for (unsigned int i = 0; i < recent_packet_count; ++i) {
+    if (recent_packets[i].fingerprint == fingerprint &&
+        now - recent_packets[i].received_at < MDNS_DUPLICATE_WINDOW_MILLIS) {
+      // Not refreshed, so a packet repeated indefinitely is still parsed once per window.
+      return true;
+    }
+  }
+
+  recent_packets[recent_packet_next].fingerprint = fingerprint;
+  recent_packets[recent_packet_next].received_at = now;
+  recent_packet_next = (recent_packet_next + 1) % MDNS_DUPLICATE_FILTER_SIZE;
+  if (recent_packet_count < MDNS_DUPLICATE_FILTER_SIZE) {
+    recent_packet_count++;
+  }
+#endif  // MDNS_DUPLICATE_FILTER_SIZE
+  return false;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::Clear() {
+  data_buffer[0] = 0;     // Query ID field which is unused in mDNS.
+  data_buffer[1] = 0;     // Query ID field which is unused in mDNS.
+  data_buffer[2] = 0;     // 0b00000000 for Query, 0b10000000 for Answer.
+  data_buffer[3] = 0;     // DNS flags which are mostly unused in mDNS.
+  data_buffer[4] = 0;     // Number of queries.
+  data_buffer[5] = 0;     // Number of queries.
+  data_buffer[6] = 0;     // Number of answers.
+  data_buffer[7] = 0;     // Number of answers.
+  data_buffer[8] = 0;     // Number of Server esource records.
+  data_buffer[9] = 0;     // Number of Server esource records.
+  data_buffer[10] = 0;     // Number of Additional resource records.
+  data_buffer[11] = 0;     // Number of Additional resource records.
+
+  data_size = 12;
+  buffer_pointer = 12;  // First byte of first Query/Record.
+  type = 0;
+  query_count = 0;
+  answer_count = 0;
+  ns_count = 0;
+  ar_count = 0;
+  for (int i = 0; i < ADDITIONAL_SECTION; ++i) {
+    section_end[i] = 12;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+unsigned int BasicMDns<PacketSize, NameLen>::PopulateName(const char* name_buffer) {
+  // TODO: This section does not match the full mDNS spec
+  // as it does not re-use strings from previous queries.
+
+  unsigned int buffer_pointer_start = buffer_pointer;
+  int word_start = 0, word_end = 0;
+  while (true) {
+    if (name_buffer[word_end] == '.' or name_buffer[word_end] == '\0') {
+      const int word_length = word_end - word_start;
+      if(buffer_pointer >= max_packet_size){
+        buffer_pointer = buffer_pointer_start;
+#ifdef DEBUG_OUTPUT
+        Serial.println(" ERROR. MDns::PopulateName overran buffer.");
+#endif
+        return 0;
+      }
+      data_buffer[buffer_pointer++] = (unsigned byte)word_length;
+      for (int i = word_start; i < word_end; ++i) {
+        if(buffer_pointer >= max_packet_size){
+          buffer_pointer = buffer_pointer_start;
+#ifdef DEBUG_OUTPUT
+          Serial.println(" ERROR. MDns::PopulateName overran buffer.");
+#endif
+          return 0;
+        }
+        data_buffer[buffer_pointer++] = name_buffer[i];
+      }
+      if(name_buffer[word_end] == '\0'){
+        break;
+      }
+      word_end++;  // Skip the '.' character.
+      word_start = word_end;
+    }
+    word_end++;
+  };
+  
+  if(buffer_pointer >= max_packet_size){
+    buffer_pointer = buffer_pointer_start;
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::PopulateName overran buffer while finishing.");
+#endif
+    return 0;
+  }
+  data_buffer[buffer_pointer++] = '\0';  // End of qname.
+
+  return buffer_pointer - buffer_pointer_start;
+}
+
+// Write a resource record's name, type, class and TTL at buffer_pointer.
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::PopulateRecordHeader(
+    const char* name, const unsigned int rrtype, const unsigned int rrclass,
+    const unsigned long int rrttl) {
+  if(PopulateName(name) == 0 || buffer_pointer +8 > max_packet_size){
+    return false;
+  }
+  data_buffer[buffer_pointer++] = (rrtype & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = rrtype & 0xFF;
+  data_buffer[buffer_pointer++] = (rrclass & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = rrclass & 0xFF;
+  data_buffer[buffer_pointer++] = (rrttl & 0xFF000000) >> 24;
+  data_buffer[buffer_pointer++] = (rrttl & 0xFF0000) >> 16;
+  data_buffer[buffer_pointer++] = (rrttl & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = (rrttl & 0xFF);
+  return true;
+}
+
+// New Queries and records are written after data_size then moved to the end of
+// their section. This keeps sections in order whatever order they are added in.
+// Names are written without compression so moving them is safe.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::CommitRecord(const Section section) {
+  const unsigned int record_len = buffer_pointer - data_size;
+  const unsigned int insert_at = section == ADDITIONAL_SECTION ? data_size : section_end[section];
+  std::rotate(data_buffer + insert_at, data_buffer + data_size, data_buffer + buffer_pointer);
+  for (int i = section; i < ADDITIONAL_SECTION; ++i) {
+    section_end[i] += record_len;
+  }
+  data_size = buffer_pointer;
+
+  // Since the data fitted in the buffer, it's ok to update the header.
+  unsigned int* count;
+  switch (section) {
+    case QUESTION_SECTION:
+      count = &query_count;
+      break;
+    case ANSWER_SECTION:
+      count = &answer_count;
+      break;
+    case AUTHORITY_SECTION:
+      count = &ns_count;
+      break;
+    default:
+      count = &ar_count;
+      break;
+  }
+  ++*count;
+  data_buffer[4 + 2 * section] = (*count & 0xFF00) >> 8;
+  data_buffer[5 + 2 * section] = *count & 0xFF;
+
+  // A packet with any Questions is a Query, whatever order records were added
+  // in. Answers in a Query are known answers. (RFC 6762 section 7.1.)
+  if (query_count) {
+    data_buffer[2] = 0;     // 0b00000000 for Query, 0b10000000 for Answer.
+    type = 1;
+  } else {
+    data_buffer[2] = 0b10000100;     // Answer & IQuery flags
+    type = 0;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddQuery(const Query& query) {
+  buffer_pointer = data_size;
+  
+  // Create DNS name buffer from qname.
+  if(PopulateName(query.qname_buffer) == 0 || buffer_pointer +4 > max_packet_size){
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddQuery overran expected buffer space.");
+#endif
+    buffer_pointer = data_size;
+    return false;
+  }
+  // The rest of the flags.
+  data_buffer[buffer_pointer++] = (query.qtype & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = query.qtype & 0xFF;
+  unsigned int qclass = 0;
+  if (query.unicast_response) {
+    qclass = 0b1000000000000000;
+  }
+  qclass += query.qclass;
+  data_buffer[buffer_pointer++] = (qclass & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = qclass & 0xFF;
+
+  CommitRecord(QUESTION_SECTION);
+
+  // Answers to this query may repeat a packet seen before it was asked, so must
+  // not be dropped as duplicates.
+  recent_packet_count = 0;
+  return true;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddAnswer(const Answer& answer) {
+  return AddRecord(answer, ANSWER_SECTION);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::CanEncode(const Answer& record) const {
+  switch (record.rrtype) {
+    case MDNS_TYPE_A:
+    case MDNS_TYPE_PTR:
+    case MDNS_TYPE_TXT:
+      return true;
+    case MDNS_TYPE_SRV:
+      {
+        unsigned int priority, weight, port;
+        int host_start = 0;
+        return sscanf(record.rdata_buffer, "p=%u;w=%u;port=%u;host=%n",
+                      &priority, &weight, &port, &host_start) == 3 && host_start;
+      }
+    default:
+      return false;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddRecord(const Answer& record, const Section section) {
+  if (section == QUESTION_SECTION || !CanEncode(record)) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddRecord can not encode this record.");
+#endif
+    return false;
+  }
+  buffer_pointer = data_size;
+
+  unsigned int rrclass = 0;
+  if (record.rrset) {
+    rrclass = 0b1000000000000000;
+  }
+  rrclass += record.rrclass;
+
+  // Create DNS name buffer from name.
+  if(!PopulateRecordHeader(record.name_buffer, record.rrtype, rrclass, record.rrttl) ||
+     buffer_pointer +2 > max_packet_size){
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddRecord over-ran buffer space.");
+#endif
+    buffer_pointer = data_size;
+    return false;
+  }
+
+  const unsigned int rdata_len_p0 = buffer_pointer++;
+  const unsigned int rdata_len_p1 = buffer_pointer++;
+  const unsigned int rdata_start = buffer_pointer;
+  bool fitted = true;
+
+  switch (record.rrtype) {
+    case MDNS_TYPE_A:  // Returns a 32-bit IPv4 address
+      if(buffer_pointer +4 > max_packet_size) {
+        fitted = false;
+        break;
+      }
+      data_buffer[buffer_pointer++] = record.rdata_buffer[0];
+      data_buffer[buffer_pointer++] = record.rdata_buffer[1];
+      data_buffer[buffer_pointer++] = record.rdata_buffer[2];
+      data_buffer[buffer_pointer++] = record.rdata_buffer[3];
+      break;
+    case MDNS_TYPE_PTR:  // Pointer to a canonical name.
+      fitted = PopulateName(record.rdata_buffer) > 0;
+      break;
+    case MDNS_TYPE_TXT:  // Length prefixed strings, as returned when parsing.
+      {
+        const unsigned int text_len = strlen(record.rdata_buffer);
+        if(buffer_pointer + (text_len ? text_len : 1) > max_packet_size) {
+          fitted = false;
+          break;
+        }
+        if (text_len) {
+          memcpy(data_buffer + buffer_pointer, record.rdata_buffer, text_len);
+          buffer_pointer += text_len;
+        } else {
+          // A TXT record with no data holds one empty string. (RFC 6763 section 6.1.)
+          data_buffer[buffer_pointer++] = 0;
+        }
+      }
+      break;
+    case MDNS_TYPE_SRV:  // Server Selection, in the "p=%u;w=%u;port=%u;host=" form parsing returns.
+      {
+        unsigned int priority, weight, port;
+        int host_start = 0;
+        if (sscanf(record.rdata_buffer, "p=%u;w=%u;port=%u;host=%n",
+                   &priority, &weight, &port, &host_start) != 3 || !host_start ||
+            buffer_pointer +6 > max_packet_size) {
+          fitted = false;
+          break;
+        }
+        data_buffer[buffer_pointer++] = (priority & 0xFF00) >> 8;
+        data_buffer[buffer_pointer++] = priority & 0xFF;
+        data_buffer[buffer_pointer++] = (weight & 0xFF00) >> 8;
+        data_buffer[buffer_pointer++] = weight & 0xFF;
+        data_buffer[buffer_pointer++] = (port & 0xFF00) >> 8;
+        data_buffer[buffer_pointer++] = port & 0xFF;
+        fitted = PopulateName(record.rdata_buffer + host_start) > 0;
+      }
+      break;
+    default:
+#ifdef DEBUG_OUTPUT
+      // TODO: Other record types.
+      Serial.println(" **ERROR** Sending this record type not implemented yet.");
+#endif
+      fitted = false;
+      break;
+  }
+  if (!fitted) {
+    buffer_pointer = data_size;
+    return false;
+  }
+
+  const unsigned int rdata_len = buffer_pointer - rdata_start;
+  data_buffer[rdata_len_p0] = (rdata_len & 0xFF00) >> 8;
+  data_buffer[rdata_len_p1] = rdata_len & 0xFF;
+
+  CommitRecord(section);
+  return true;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddNsec(const char* name) {
+  const int name_index = FindOwnedName(name);
+  if (name_index < 0 || !HasUniqueRecord(name_index)) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddNsec name has no unique owned records.");
+#endif
+    return false;
+  }
+  return AddNsecRecord(name_index, ADDITIONAL_SECTION);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddNsecRecord(const unsigned int name_index,
+                                                   const Section section) {
+  buffer_pointer = data_size;
+
+  const OwnedName& owned = owned_names[name_index];
+  const unsigned int name_size = strlen(owned.name) + 2;
+  const unsigned int bitmap_size = owned.nsec_bitmap[1] + 2;
+
+  // Cache flush bit and INternet class.
+  // rdata is the Next Domain Name (the owner name again) and the type bitmap.
+  if (!PopulateRecordHeader(owned.name, MDNS_TYPE_NSEC, 0b1000000000000001, owned.ttl) ||
+      buffer_pointer + 2 + name_size + bitmap_size > max_packet_size) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddNsecRecord over-ran buffer space.");
+#endif
+    buffer_pointer = data_size;
+    return false;
+  }
+
+  const unsigned int rdata_len = name_size + bitmap_size;
+  data_buffer[buffer_pointer++] = (rdata_len & 0xFF00) >> 8;
+  data_buffer[buffer_pointer++] = rdata_len & 0xFF;
+
+  PopulateName(owned.name);
+  memcpy(data_buffer + buffer_pointer, owned.nsec_bitmap, bitmap_size);
+  buffer_pointer += bitmap_size;
+
+  CommitRecord(section);
+  return true;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::AddOwnedRecord(const Answer* record) {
+  // Only records AddRecord() can encode, or the NSEC bitmap would claim a type
+  // that is never sent.
+  if (owned_record_count >= MAX_MDNS_OWNED_RECORDS || !CanEncode(*record)) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::AddOwnedRecord can not own this record.");
+#endif
+    return false;
+  }
+
+  int name_index = FindOwnedName(record->name_buffer);
+  if (name_index < 0) {
+    name_index = owned_name_count++;
+    OwnedName& owned = owned_names[name_index];
+    owned.name = record->name_buffer;
+    owned.ttl = record->rrttl;
+    memset(owned.nsec_bitmap, 0, sizeof(owned.nsec_bitmap));
+  }
+
+  // Set the bit for this type in Window block 0 and extend the bitmap length
+  // to cover it.
+  OwnedName& owned = owned_names[name_index];
+  const unsigned int type_byte = record->rrtype / 8;
+  owned.nsec_bitmap[2 + type_byte] |= 0b10000000 >> (record->rrtype % 8);
+  if (owned.nsec_bitmap[1] < type_byte + 1) {
+    owned.nsec_bitmap[1] = type_byte + 1;
+  }
+
+  owned_records[owned_record_count] = record;
+  owned_record_name[owned_record_count] = name_index;
+  owned_record_count++;
+  if (probed) {
+    // Already claimed names must not be answered for until the new record is probed.
+    probe();
+  }
+  return true;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::ClearOwnedRecords() {
+  owned_record_count = 0;
+  owned_name_count = 0;
+}
+
+// True if name has any unique owned records, which are the ones probed.
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::HasUniqueRecord(const unsigned int name_index) const {
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    if (owned_record_name[i] == name_index && owned_records[i]->rrset) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// True if answer, just parsed from another host, claims a name we hold unique
+// records for. Shared records may be answered by any number of hosts, and an
+// answer with the same rdata as ours is not a conflict. (RFC 6762 section 9.)
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::IsConflict(const Answer& answer) const {
+  bool conflict = false;
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    const Answer& record = *owned_records[i];
+    if (!record.rrset || strcasecmp(record.name_buffer, answer.name_buffer) != 0) {
+      continue;
+    }
+    if (record.rrtype == answer.rrtype && SameRdata(answer, record)) {
+      return false;
+    }
+    conflict = true;
+  }
+  return conflict;
+}
+
+// Compare the rdata of the Answer just parsed with an owned record.
+// A and TXT are compared as sent. Names may be compressed so PTR and SRV are
+// compared in parsed form.
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::SameRdata(const Answer& answer,
+                                                const Answer& record) const {
+  if (rdata_pointer + rdata_length > data_size) {
+    return false;
+  }
+  const byte* rdata = data_buffer + rdata_pointer;
+  switch (record.rrtype) {
+    case MDNS_TYPE_A:
+      return rdata_length == 4 && memcmp(rdata, record.rdata_buffer, 4) == 0;
+    case MDNS_TYPE_TXT:
+      {
+        const unsigned int text_len = strlen(record.rdata_buffer);
+        if (!text_len) {
+          return rdata_length == 1 && rdata[0] == 0;
+        }
+        return rdata_length == text_len && memcmp(rdata, record.rdata_buffer, text_len) == 0;
+      }
+    default:
+      return strcasecmp(answer.rdata_buffer, record.rdata_buffer) == 0;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+int BasicMDns<PacketSize, NameLen>::FindOwnedName(const char* name) const {
+  for (unsigned int i = 0; i < owned_name_count; ++i) {
+    if (strcasecmp(owned_names[i].name, name) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::QueueResponse(const Query& query) {
+  if (query.qclass != 0x01 && query.qclass != 0xFF) {
+    return;
+  }
+  const int name_index = FindOwnedName(query.qname_buffer);
+  if (name_index < 0) {
+    return;
+  }
+
+  bool answered = false;
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    if (owned_record_name[i] == name_index &&
+        (query.qtype == MDNS_TYPE_ANY || query.qtype == owned_records[i]->rrtype)) {
+      pending_records |= 1 << i;
+      answered = true;
+    }
+  }
+  // Only a name we own exclusively can be asserted to have no other records.
+  // (RFC 6762 section 6.1.)
+  if (HasUniqueRecord(name_index)) {
+    if (answered) {
+      pending_positive_names |= 1 << name_index;
+    } else {
+      pending_negative_names |= 1 << name_index;
+    }
+  }
+
+  if (!query.unicast_response) {
+    pending_multicast = true;
+  }
+}
+
+// Drop an owned record from the pending response if the Query lists it as a
+// known answer with at least half its TTL left. (RFC 6762 section 7.1.)
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SuppressKnownAnswer(const Answer& answer) {
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    const Answer& record = *owned_records[i];
+    if (!(pending_records & (1 << i)) || record.rrtype != answer.rrtype ||
+        record.rrclass != answer.rrclass || answer.rrttl < record.rrttl / 2 ||
+        strcasecmp(record.name_buffer, answer.name_buffer) != 0 || !SameRdata(answer, record)) {
+      continue;
+    }
+    pending_records &= ~(1 << i);
+
+    // No NSEC either if none of the name's records are still being sent.
+    bool name_pending = false;
+    for (unsigned int j = 0; j < owned_record_count; ++j) {
+      if (owned_record_name[j] == owned_record_name[i] && (pending_records & (1 << j))) {
+        name_pending = true;
+      }
+    }
+    if (!name_pending) {
+      pending_positive_names &= ~(1 << owned_record_name[i]);
+    }
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendResponse() {
+  const IPAddress* unicast = pending_multicast ? NULL : &srcIP;
+  Clear();
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    if (pending_records & (1 << i)) {
+      AddOrSplit([this, i]() { return AddAnswer(*owned_records[i]); }, false, unicast);
+    }
+  }
+  // Negative responses carry the NSEC in the Answer section.
+  for (unsigned int i = 0; i < owned_name_count; ++i) {
+    if (pending_negative_names & (1 << i)) {
+      AddOrSplit([this, i]() { return AddNsecRecord(i, ANSWER_SECTION); }, false, unicast);
+    }
+  }
+  // Positive responses carry the NSEC in the Additional section.
+  for (unsigned int i = 0; i < owned_name_count; ++i) {
+    if ((pending_positive_names & ~pending_negative_names) & (1 << i)) {
+      AddOrSplit([this, i]() { return AddNsecRecord(i, ADDITIONAL_SECTION); }, false, unicast);
+    }
+  }
+
+  if (data_size > 12) {
+    SendSplitPacket(false, false, unicast);
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::probe() {
+  probed = true;
+  conflict = false;
+  if (!owned_record_count) {
+    probe_step = MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT;
+    return;
+  }
+  // Random delay so devices powered up together do not probe in step.
+  probe_step = 0;
+  probe_next_at = millis() + random(MDNS_PROBE_MAX_DELAY_MILLIS);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::probing() const {
+  // Conflicts are still watched for between the last probe and the first announcement.
+  return probe_step <= MDNS_PROBE_COUNT && probe_step < MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::conflicted() const {
+  return conflict;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::setConflictCallback(ConflictCallback callback) {
+  conflict_callback = callback;
+}
+
+// Send the next probe or announcement if it is due.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::RunProbe() {
+  if (probe_step >= MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT) {
+    return;
+  }
+  const unsigned long now = millis();
+  if ((long)(now - probe_next_at) < 0) {
+    return;
+  }
+  if (!owned_record_count) {
+    probe_step = MDNS_PROBE_COUNT + MDNS_ANNOUNCE_COUNT;
+    return;
+  }
+  if (probe_step < MDNS_PROBE_COUNT) {
+    bool any_unique = false;
+    for (unsigned int i = 0; i < owned_name_count; ++i) {
+      any_unique = any_unique || HasUniqueRecord(i);
+    }
+    if (!any_unique) {
+      // Shared records are announced without probing. (RFC 6762 section 8.1.)
+      probe_step = MDNS_PROBE_COUNT;
+    }
+  }
+
+  if (probe_step < MDNS_PROBE_COUNT) {
+    // Only the first probe asks for a unicast reply. (RFC 6762 section 8.1.)
+    SendProbe(probe_step == 0);
+    probe_next_at = now + MDNS_PROBE_INTERVAL_MILLIS;
+  } else {
+    SendAnnouncement();
+    probe_next_at = now + MDNS_ANNOUNCE_INTERVAL_MILLIS;
+  }
+  probe_step++;
+}
+
+// Ask for every owned name with unique records, with those records in the
+// Authority section.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendProbe(const bool unicast_response) {
+  Clear();
+  for (unsigned int i = 0; i < owned_name_count; ++i) {
+    if (!HasUniqueRecord(i)) {
+      continue;
+    }
+    Query query;
+    strncpy(query.qname_buffer, owned_names[i].name, NameLen - 1);
+    query.qname_buffer[NameLen - 1] = '\0';
+    query.qtype = MDNS_TYPE_ANY;
+    query.qclass = 1;    // "INternet"
+    query.unicast_response = unicast_response;
+    AddOrSplit([this, &query]() { return AddQuery(query); }, true, NULL);
+  }
+  for (unsigned int i = 0; i < owned_record_count; ++i) {
+    if (!owned_records[i]->rrset) {
+      continue;
+    }
+    AddOrSplit([this, i]() { return AddRecord(*owned_records[i], AUTHORITY_SECTION); },
+               true, NULL);
+  }
+  if (data_size > 12) {
+    SendSplitPacket(true, false, NULL);
+  }
+}
+
+// Multicast every owned record, as if answering an ANY query for each owned name.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendAnnouncement() {
+  pending_records = (1 << owned_record_count) - 1;
+  pending_positive_names = 0;
+  for (unsigned int i = 0; i < owned_name_count; ++i) {
+    if (HasUniqueRecord(i)) {
+      pending_positive_names |= 1 << i;
+    }
+  }
+  pending_negative_names = 0;
+  pending_multicast = true;
+  SendResponse();
+  pending_records = 0;
+  pending_positive_names = 0;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::SendRecords(const Answer* const* records,
+                                                 const unsigned int record_count,
+                                                 const Section section) {
+  bool all_sent = true;
+  Clear();
+  for (unsigned int i = 0; i < record_count; ++i) {
+    const Answer* record = records[i];
+    if (!CanEncode(*record)) {
+      // Not a full packet, so do not split.
+      all_sent = false;
+      continue;
+    }
+    if (!AddOrSplit([this, record, section]() { return AddRecord(*record, section); },
+                    false, NULL)) {
+      all_sent = false;
+    }
+  }
+  if (data_size > 12) {
+    SendSplitPacket(false, false, NULL);
+  }
+  return all_sent;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::SendQueries(const Query* const* queries,
+                                                 const unsigned int query_count_,
+                                                 const Answer* const* known_answers,
+                                                 const unsigned int known_answer_count) {
+  bool all_sent = true;
+  Clear();
+  for (unsigned int i = 0; i < query_count_; ++i) {
+    const Query* query = queries[i];
+    if (!AddOrSplit([this, query]() { return AddQuery(*query); }, true, NULL)) {
+      all_sent = false;
+    }
+  }
+  for (unsigned int i = 0; i < known_answer_count; ++i) {
+    const Answer* answer = known_answers[i];
+    if (!CanEncode(*answer)) {
+      // Not a full packet, so do not split.
+      all_sent = false;
+      continue;
+    }
+    if (!AddOrSplit([this, answer]() { return AddRecord(*answer, ANSWER_SECTION); },
+                    true, NULL)) {
+      all_sent = false;
+    }
+  }
+  if (data_size > 12) {
+    SendSplitPacket(true, false, NULL);
+  }
+  return all_sent;
+}
+
+// Run add. If it does not fit, send the packet built so far and run add again
+// on an empty packet. Every failure of add is taken to mean the packet is full,
+// so check CanEncode() first.
+// Returns false if add does not fit even in an empty packet.
+template <unsigned int PacketSize, unsigned int NameLen>
+template <typename Add>
+bool BasicMDns<PacketSize, NameLen>::AddOrSplit(const Add& add, const bool query,
+                                                const IPAddress* unicast) {
+  if (add()) {
+    return true;
+  }
+  if (data_size <= 12) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. Record does not fit in an empty packet.");
+#endif
+    return false;
+  }
+  SendSplitPacket(query, true, unicast);
+  Clear();
+  return add();
+}
+
+// Set the flags for one packet of a split Query or response and send it.
+// Queries that continue in another packet have the TC bit set. (RFC 6762 section 7.2.)
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendSplitPacket(const bool query, const bool more_follows,
+                                                     const IPAddress* unicast) {
+  if (query) {
+    data_buffer[2] = more_follows ? 0b00000010 : 0;     // Query, truncated.
+  } else {
+    data_buffer[2] = 0b10000100;     // Answer & IQuery flags
+  }
+  if (unicast) {
+    SendUnicast(*unicast);
+  } else {
+    Send();
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::setResolver(Resolver* resolver_) {
+  resolver = resolver_;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+bool BasicMDns<PacketSize, NameLen>::resolve(const char* name, ResolveCallback callback,
+                                             const unsigned long timeout_ms) {
+  if (!resolver) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. MDns::resolve called without setResolver().");
+#endif
+    return false;
+  }
+  return resolver->Add(name, callback, timeout_ms);
+}
+
+// Send one packet asking all the names whose query is due.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendResolveQueries() {
+  bool cleared = false;
+
+  for (unsigned int i = 0; i < resolver->max_lookups(); ++i) {
+    const char* name = resolver->DueQuery(i);
+    if (!name) {
+      continue;
+    }
+    if (strlen(name) >= NameLen) {
+      // Too long for this MDns to ask. The lookup times out.
+      resolver->QuerySent(i);
+      continue;
+    }
+    if (!cleared) {
+      Clear();
+      cleared = true;
+    }
+    Query query;
+    strcpy(query.qname_buffer, name);
+    query.qtype = MDNS_TYPE_A;
+    query.qclass = 1;    // "INternet"
+    query.unicast_response = false;
+    if (!AddQuery(query)) {
+      // No room left in this packet. Try again on the next loop().
+      break;
+    }
+    resolver->QuerySent(i);
+  }
+
+  if (cleared && query_count) {
+    Send();
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::ResolveAnswer(const Answer& answer) {
+  if (!resolver || rdata_pointer + 4 > data_size) {
+    return;
+  }
+  const IPAddress address(data_buffer[rdata_pointer], data_buffer[rdata_pointer + 1],
+                          data_buffer[rdata_pointer + 2], data_buffer[rdata_pointer + 3]);
+  resolver->Answer(answer.name_buffer, address, answer.rrttl);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::Send() const {
+#ifdef DEBUG_OUTPUT
+  Serial.println("Sending UDP multicast packet");
+#endif
+  Udp.begin(MDNS_SOURCE_PORT);
+  Udp.beginPacketMulticast(IPAddress(224, 0, 0, 251), MDNS_TARGET_PORT, WiFi.localIP(), MDNS_TTL);
+  Udp.write(data_buffer, data_size);
+  Udp.endPacket();
+  if (capture) {
+    capture->Record(data_buffer, data_size, WiFi.localIP(), IPAddress(224, 0, 0, 251),
+                    MDNS_CAPTURE_TX);
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::SendUnicast(IPAddress addr) const {
+#ifdef DEBUG_OUTPUT
+  Serial.println("Sending UDP unicast packet");
+#endif
+  Udp.beginPacket(addr,MDNS_TARGET_PORT);
+  Udp.write(data_buffer, data_size);
+  Udp.endPacket();
+  if (capture) {
+    capture->Record(data_buffer, data_size, WiFi.localIP(), addr, MDNS_CAPTURE_TX);
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::Display() const {
+  Serial.println();
+  Serial.print("Packet size: ");
+  Serial.print(data_size);
+  Serial.print("  ");
+  Serial.println(data_size, HEX);
+  Serial.print(" TYPE: ");
+  Serial.print(type);
+  Serial.print("      QUERY_COUNT: ");
+  Serial.print(query_count);
+  Serial.print("      ANSWER_COUNT: ");
+  Serial.print(answer_count);
+  Serial.print("      NS_COUNT: ");
+  Serial.print(ns_count);
+  Serial.print("      AR_COUNT: ");
+  Serial.println(ar_count);
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::Parse_Query(Query& query) {
+#ifdef DEBUG_OUTPUT
+  query.buffer_pointer = buffer_pointer;
+#endif
+
+  buffer_pointer = nameFromDnsPointer(query.qname_buffer, 0, NameLen,
+                                      data_buffer, buffer_pointer);
+
+  byte qtype_0 = data_buffer[buffer_pointer++];
+  byte qtype_1 = data_buffer[buffer_pointer++];
+  byte qclass_0 = data_buffer[buffer_pointer++];
+  byte qclass_1 = data_buffer[buffer_pointer++];
+
+  query.qtype = (qtype_0 << 8) + qtype_1;
+
+  query.unicast_response = (0b10000000 & qclass_0);
+  query.qclass = ((qclass_0 & 0b01111111) << 8) + qclass_1;
+
+  query.valid = true;
+
+  if (query.qclass != 0xFF && query.qclass != 0x01) {
+    // QCLASS is not ANY (0xFF) or INternet (0x01).
+#ifdef DEBUG_OUTPUT
+    Serial.print(" **ERROR QCLASS** ");
+    Serial.println(query.qclass, HEX);
+#endif
+    query.valid = false;
+  }
+
+  if (buffer_pointer > data_size) {
+    // We've over-run the returned data.
+    // Something has gone wrong receiving or parsing the data.
+#ifdef DEBUG_OUTPUT
+    Serial.print(" **ERROR size** ");
+    Serial.print(buffer_pointer, HEX);
+    Serial.print(" ");
+    Serial.println(data_size, HEX);
+#endif
+    query.valid = false;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::Parse_Answer(Answer& answer) {
+#ifdef DEBUG_OUTPUT
+  answer.buffer_pointer = buffer_pointer;
+#endif
+
+  buffer_pointer = nameFromDnsPointer(answer.name_buffer, 0, NameLen,
+                                      data_buffer, buffer_pointer);
+
+  answer.rrtype = (data_buffer[buffer_pointer++] << 8);
+  answer.rrtype += data_buffer[buffer_pointer++];
+
+  byte rrclass_0 = data_buffer[buffer_pointer++];
+  byte rrclass_1 = data_buffer[buffer_pointer++];
+  answer.rrset = (0b10000000 & rrclass_0);
+  answer.rrclass = ((rrclass_0 & 0b01111111) << 8) + rrclass_1;
+
+  answer.rrttl = (data_buffer[buffer_pointer++] << 24);
+  answer.rrttl += (data_buffer[buffer_pointer++] << 16);
+  answer.rrttl += (data_buffer[buffer_pointer++] << 8);
+  answer.rrttl += data_buffer[buffer_pointer++];
+  
+  if (buffer_pointer > data_size) {
+    // We've over-run the returned data.
+    // Something has gone wrong receiving or parsing the data.
+#ifdef DEBUG_OUTPUT
+    Serial.print(" **ERROR size** ");
+    Serial.print(buffer_pointer, HEX);
+    Serial.print(" ");
+    Serial.println(data_size, HEX);
+#endif
+    answer.valid = false;
+    return;
+  }
+  PopulateAnswerResult(&answer);
+
+  answer.valid = true;
+}
+
+// Display packet contents in HEX.
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::DisplayRawPacket() const {
+  // display the packet contents in HEX
+  Serial.println("Raw packet");
+  unsigned int i, j;
+
+  for (i = 0; i <= data_size; i += 16) {
+    Serial.print("0x");
+    PrintHex(i >> 8); PrintHex(i);
+    Serial.print("   ");
+    for (j = 0; j < 16; j++) {
+      if (i + j >= data_size) {
+        break;
+      }
+      if (data_buffer[i + j] > 31 and data_buffer[i + j] < 128) {
+        Serial.print((char)data_buffer[i + j]);
+      } else {
+        Serial.print(".");
+      }
+    }
+    Serial.print("    ");
+    for (j = 0; j < 16; j++) {
+      if (i + j >= data_size) {
+        break;
+      }
+      PrintHex(data_buffer[i + j]);
+      Serial.print(' ');
+    }
+    Serial.println();
+  }
+}
+
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::PopulateAnswerResult(Answer* answer) {
+  int rdlength = (data_buffer[buffer_pointer++] << 8);
+  rdlength += data_buffer[buffer_pointer++];
+  rdata_pointer = buffer_pointer;
+  rdata_length = rdlength;
+
+  switch (answer->rrtype) {
+    case MDNS_TYPE_A:  // Returns a 32-bit IPv4 address
+      if (NameLen >= 16) {
+        sprintf(answer->rdata_buffer, "%u.%u.%u.%u",
+                data_buffer[buffer_pointer], data_buffer[buffer_pointer +1],
+                data_buffer[buffer_pointer +2], data_buffer[buffer_pointer +3]);
+      } else {
+        sprintf(answer->rdata_buffer, "ipv4");
+      }
+      buffer_pointer += 4;
+      break;
+    case MDNS_TYPE_PTR:  // Pointer to a canonical name.
+      buffer_pointer = nameFromDnsPointer(answer->rdata_buffer, 0, NameLen,
+                                          data_buffer, buffer_pointer);
+      break;
+    case MDNS_TYPE_HINFO:  // HINFO. host information
+      buffer_pointer = parseText(answer->rdata_buffer, NameLen, rdlength,
+                                 data_buffer, buffer_pointer);
+      break;
+    case MDNS_TYPE_TXT:  // Originally for arbitrary human-readable text in a DNS record.
+      // We only return the first NameLen bytes of thir record type.
+      buffer_pointer = parseText(answer->rdata_buffer, NameLen, rdlength,
+                                 data_buffer, buffer_pointer);
+      break;
+    case MDNS_TYPE_AAAA:  // Returns a 128-bit IPv6 address.
+      {
+        int buffer_pos = 0;
+        for (int i = 0; i < rdlength; i++) {
+          if (buffer_pos < (int)NameLen - 3) {
+            sprintf(answer->rdata_buffer + buffer_pos, "%02X:", data_buffer[buffer_pointer++]);
+          } else {
+            buffer_pointer++;
+          }
+          buffer_pos += 3;
+        }
+        answer->rdata_buffer[--buffer_pos] = '\0';  // Remove trailing ':'
+      }
+      break;
+    case MDNS_TYPE_SRV:  // Server Selection.
+      {
+        unsigned int priority = (data_buffer[buffer_pointer++] << 8);
+        priority += data_buffer[buffer_pointer++];
+        unsigned int weight = (data_buffer[buffer_pointer++] << 8);
+        weight += data_buffer[buffer_pointer++];
+        unsigned int port = (data_buffer[buffer_pointer++] << 8);
+        port += data_buffer[buffer_pointer++];
+        sprintf(answer->rdata_buffer, "p=%u;w=%u;port=%u;host=", priority, weight, port);
+
+        buffer_pointer = nameFromDnsPointer(answer->rdata_buffer, strlen(answer->rdata_buffer), 
+            NameLen - strlen(answer->rdata_buffer) -1, data_buffer, buffer_pointer);
+      }
+      break;
+    default:
+      {
+        int buffer_pos = 0;
+        for (int i = 0; i < rdlength; i++) {
+          if (buffer_pos < (int)NameLen - 3) {
+            sprintf(answer->rdata_buffer + buffer_pos, "%02X ", data_buffer[buffer_pointer++]);
+          } else {
+            buffer_pointer++;
+          }
+          buffer_pos += 3;
+        }
+      }
+      break;
+  }
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::setCapture(PacketCapture* capture_) {
+  capture = capture_;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+void BasicMDns<PacketSize, NameLen>::setReceiveQueue(PacketQueue* receive_queue_) {
+  receive_queue = receive_queue_;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+IPAddress BasicMDns<PacketSize, NameLen>::getRemoteIP() {
+  return srcIP;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+IPAddress BasicMDns<PacketSize, NameLen>::getDestinationIP() {
+  return destIP;
+}
+
+template <unsigned int PacketSize, unsigned int NameLen>
+BasicMDns<PacketSize, NameLen>::~BasicMDns(){
+  Udp.stop();
+  if (owns_data_buffer) {
+    delete[] data_buffer;
+  }
+};
+
+template <unsigned int NameLen>
+void BasicQuery<NameLen>::Display() const {
+#ifdef DEBUG_OUTPUT
+  Serial.print("question  0x");
+  Serial.println(buffer_pointer, HEX);
+#endif
+  if (!valid) {
+    Serial.println(" **ERROR**");
+  }
+  Serial.print(" QNAME:    ");
+  Serial.println(qname_buffer);
+  Serial.print(" QTYPE:  0x");
+  Serial.print(qtype, HEX);
+  Serial.print("      QCLASS: 0x");
+  Serial.print(qclass, HEX);
+  Serial.print("      Unicast Response: ");
+  Serial.println(unicast_response);
+}
+
+template <unsigned int NameLen>
+void BasicAnswer<NameLen>::Display() const {
+#ifdef DEBUG_OUTPUT
+  Serial.print("answer  0x");
+  Serial.println(buffer_pointer, HEX);
+#endif
+  if (!valid) {
+    Serial.println(" **ERROR**");
+  }
+  Serial.print(" RRNAME:    ");
+  Serial.println(name_buffer);
+  Serial.print(" RRTYPE:  0x");
+  Serial.print(rrtype, HEX);
+  Serial.print("      RRCLASS: 0x");
+  Serial.print(rrclass, HEX);
+  Serial.print("      RRTTL: ");
+  Serial.print(rrttl);
+  Serial.print("      RRSET: ");
+  Serial.println(rrset);
+  Serial.print(" RRDATA:    ");
+  Serial.println(rdata_buffer);
+}
+
+} // namespace mdns
+
+#endif  // MDNS_IMPL_H
@@ -0,0 +1,79 @@
+#include <Arduino.h>
+#include "mdns.h"
+
+
+namespace mdns {
+
+
+PacketQueue::PacketQueue(QueueSlot* slots_, byte* data_, unsigned int slot_count_,
+                         unsigned int slot_size_) :
+    slots(slots_),
+    data(data_),
+    slot_count(slot_count_),
+    slot_size(slot_size_),
+    head(0),
+    tail(0),
+    dropped_count(0) {
+}
+
+bool PacketQueue::Push(const byte* packet, unsigned int packet_len, IPAddress src,
+                       IPAddress dst) {
+  const unsigned int position = head.load(std::memory_order_relaxed);
+  if (Waiting(position, tail.load(std::memory_order_acquire)) >= slot_count) {
+    dropped_count.store(dropped_count.load(std::memory_order_relaxed) + 1,
+                        std::memory_order_relaxed);
+    return false;
+  }
+  const unsigned int index = position % slot_count;
+  QueueSlot& slot = slots[index];
+  for (int i = 0; i < 4; ++i) {
+    slot.src[i] = src[i];
+    slot.dst[i] = dst[i];
+  }
+  slot.orig_len = packet_len;
+  slot.len = packet_len > slot_size ? slot_size : packet_len;
+  memcpy(data + index * slot_size, packet, slot.len);
+
+  // Publish the slot only once its contents are written.
+  head.store(Advance(position), std::memory_order_release);
+  return true;
+}
+
+unsigned int PacketQueue::Pop(byte* buffer, unsigned int buffer_len, IPAddress* src,
+                              IPAddress* dst, unsigned int* orig_len) {
+  const unsigned int position = tail.load(std::memory_order_relaxed);
+  if (position == head.load(std::memory_order_acquire)) {
+    return 0;
+  }
+  const unsigned int index = position % slot_count;
+  const QueueSlot& slot = slots[index];
+  const unsigned int len = slot.len > buffer_len ? buffer_len : slot.len;
+  memcpy(buffer, data + index * slot_size, len);
+  *src = IPAddress(slot.src[0], slot.src[1], slot.src[2], slot.src[3]);
+  *dst = IPAddress(slot.dst[0], slot.dst[1], slot.dst[2], slot.dst[3]);
+  *orig_len = slot.orig_len;
+
+  // Hand the slot back to the producer only once it has been copied out.
+  tail.store(Advance(position), std::memory_order_release);
+  return len;
+}
+
+unsigned int PacketQueue::count() const {
+  return Waiting(head.load(std::memory_order_acquire), tail.load(std::memory_order_acquire));
+}
+
+unsigned int PacketQueue::Advance(const unsigned int position) const {
+  return position + 1 == 2 * slot_count ? 0 : position + 1;
+}
+
+unsigned int PacketQueue::Waiting(const unsigned int head_position,
+                                  const unsigned int tail_position) const {
+  return head_position >= tail_position ? head_position - tail_position
+                                        : head_position + 2 * slot_count - tail_position;
+}
+
+unsigned long PacketQueue::dropped() const {
+  return dropped_count.load(std::memory_order_relaxed);
+}
+
+} // namespace mdns
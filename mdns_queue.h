@@ -0,0 +1,85 @@
+#ifndef MDNS_QUEUE_H
+#define MDNS_QUEUE_H
+
+#include <Arduino.h>
+
+#include <atomic>
+
+namespace mdns{
+
+// Details of one datagram held by PacketQueue.
+struct QueueSlot{
+  byte src[4];                   // Source IP address.
+  byte dst[4];                   // Destination IP address.
+  unsigned int len;              // Bytes held. May be less than orig_len.
+  unsigned int orig_len;         // Size of the datagram on the wire.
+};
+
+// Lock free ring of received datagrams, filled by one producer and drained by
+// one consumer.
+// The producer is whatever receives datagrams as they arrive, eg: the receive
+// callback of an asynchronous UDP library or a reader thread on a host build.
+// The consumer is MDns::loop(). Attach with MDns::setReceiveQueue().
+// Use BasicPacketQueue<> to have the storage embedded in the object.
+class PacketQueue {
+ public:
+  // Args:
+  //   slots_ : Array of slot_count_ QueueSlot.
+  //   data_ : Buffer of slot_count_ * slot_size_ bytes to hold datagram contents.
+  //   slot_count_ : How many datagrams can wait at once.
+  //   slot_size_ : Datagrams longer than this are truncated.
+  PacketQueue(QueueSlot* slots_, byte* data_, unsigned int slot_count_,
+              unsigned int slot_size_);
+
+  // Producer side. Copy a datagram into the next free slot.
+  // Returns false, and counts the datagram as dropped, if every slot is full.
+  bool Push(const byte* packet, unsigned int packet_len, IPAddress src, IPAddress dst);
+
+  // Consumer side. Copy the oldest datagram into buffer and free its slot.
+  // orig_len is set to the size of the datagram on the wire.
+  // Returns the number of bytes copied, or 0 if the queue is empty.
+  unsigned int Pop(byte* buffer, unsigned int buffer_len, IPAddress* src, IPAddress* dst,
+                   unsigned int* orig_len);
+
+  // Number of datagrams waiting. Either side may call this.
+  unsigned int count() const;
+
+  // Number of datagrams dropped by Push() because the queue was full.
+  unsigned long dropped() const;
+
+ private:
+  QueueSlot* slots;
+  byte* data;
+  unsigned int slot_count;
+  unsigned int slot_size;
+
+  // Position after the next one, wrapping at 2 * slot_count.
+  unsigned int Advance(const unsigned int position) const;
+  // Datagrams between tail_position and head_position.
+  unsigned int Waiting(const unsigned int head_position, const unsigned int tail_position) const;
+
+  // Positions of the next datagram to push and to pop. They count modulo
+  // 2 * slot_count, so a full queue can be told from an empty one and both
+  // map to slots consistently whatever slot_count is. The slot used is the
+  // position modulo slot_count. Only the producer writes head and
+  // dropped_count, and only the consumer writes tail.
+  std::atomic<unsigned int> head;
+  std::atomic<unsigned int> tail;
+  std::atomic<unsigned long> dropped_count;
+};
+
+// PacketQueue with storage for Slots datagrams of up to SlotSize bytes
+// embedded in the object.
+template <unsigned int Slots, unsigned int SlotSize>
+class BasicPacketQueue : public PacketQueue {
+ public:
+  BasicPacketQueue() : PacketQueue(slot_storage, data_storage, Slots, SlotSize) {}
+
+ private:
+  QueueSlot slot_storage[Slots];
+  byte data_storage[Slots * SlotSize];
+};
+
+} // namespace mdns
+
+#endif  // MDNS_QUEUE_H
@@ -0,0 +1,215 @@
+#include <Arduino.h>
+#include "mdns.h"
+
+
+namespace mdns {
+
+
+Resolver::Resolver(PendingResolve* lookups_, unsigned int lookup_count_,
+                   CachedAddress* cache_, unsigned int cache_count_,
+                   ResolveCallback* callbacks_, byte* callback_owners_,
+                   unsigned long* callback_timeouts_, unsigned int callback_count_,
+                   char* names_, unsigned int name_len_) :
+    lookups(lookups_),
+    lookup_count(lookup_count_),
+    cache(cache_),
+    cache_count(cache_count_),
+    callbacks(callbacks_),
+    callback_owners(callback_owners_),
+    callback_timeouts(callback_timeouts_),
+    callback_count(callback_count_),
+    names(names_),
+    name_len(name_len_) {
+  memset(names, 0, (lookup_count + cache_count + 1) * name_len);
+}
+
+bool Resolver::Add(const char* name, ResolveCallback callback, const unsigned long timeout_ms) {
+  const unsigned long now = millis();
+
+  for (unsigned int i = 0; i < cache_count; ++i) {
+    if (cache_name(i)[0] && (long)(now - cache[i].expires_at) < 0 &&
+        strcasecmp(cache_name(i), name) == 0) {
+      callback(name, cache[i].address);
+      return true;
+    }
+  }
+
+  unsigned int callback_index = 0;
+  while (callback_index < callback_count && callbacks[callback_index]) {
+    ++callback_index;
+  }
+  if (callback_index == callback_count) {
+#ifdef DEBUG_OUTPUT
+    Serial.println(" ERROR. Resolver has no free callback slots.");
+#endif
+    return false;
+  }
+
+  const unsigned long timeout_at = now + timeout_ms;
+
+  // Join a lookup already in progress for this name.
+  int lookup_index = -1;
+  for (unsigned int i = 0; i < lookup_count; ++i) {
+    if (lookup_name(i)[0] && strcasecmp(lookup_name(i), name) == 0) {
+      lookup_index = i;
+      // Keep asking until the last waiting callback gives up.
+      if ((long)(timeout_at - lookups[i].timeout_at) > 0) {
+        lookups[i].timeout_at = timeout_at;
+      }
+      break;
+    }
+  }
+
+  if (lookup_index < 0) {
+    for (unsigned int i = 0; i < lookup_count; ++i) {
+      if (!lookup_name(i)[0]) {
+        lookup_index = i;
+        break;
+      }
+    }
+    if (lookup_index < 0 || strlen(name) >= name_len || !name[0]) {
+#ifdef DEBUG_OUTPUT
+      Serial.println(" ERROR. Resolver can not track this lookup.");
+#endif
+      return false;
+    }
+    PendingResolve& lookup = lookups[lookup_index];
+    strcpy(lookup_name(lookup_index), name);
+    lookup.timeout_at = timeout_at;
+    // The query goes out from the next MDns::loop() so any packet being built
+    // by the caller is not overwritten.
+    lookup.next_query_at = now;
+    lookup.retry_interval = MDNS_RESOLVE_RETRY_MILLIS;
+  }
+
+  callbacks[callback_index] = callback;
+  callback_owners[callback_index] = lookup_index;
+  callback_timeouts[callback_index] = timeout_at;
+  return true;
+}
+
+void Resolver::RunTimers() {
+  const unsigned long now = millis();
+
+  for (unsigned int i = 0; i < cache_count; ++i) {
+    if (cache_name(i)[0] && (long)(now - cache[i].expires_at) >= 0) {
+      cache_name(i)[0] = '\0';
+    }
+  }
+
+  // Callbacks that joined a lookup with a shorter timeout give up on their own.
+  for (unsigned int i = 0; i < callback_count; ++i) {
+    if (callbacks[i] && (long)(now - callback_timeouts[i]) >= 0 &&
+        (long)(now - lookups[callback_owners[i]].timeout_at) < 0) {
+      // Release the slot first in case the callback calls resolve() again.
+      ResolveCallback callback = callbacks[i];
+      callbacks[i] = NULL;
+      callback(lookup_name(callback_owners[i]), IPAddress(0, 0, 0, 0));
+    }
+  }
+
+  for (unsigned int i = 0; i < lookup_count; ++i) {
+    if (lookup_name(i)[0] && (long)(now - lookups[i].timeout_at) >= 0) {
+      Finish(i, IPAddress(0, 0, 0, 0));
+    }
+  }
+}
+
+const char* Resolver::DueQuery(const unsigned int index) const {
+  if (!lookup_name(index)[0] || (long)(millis() - lookups[index].next_query_at) < 0) {
+    return NULL;
+  }
+  return lookup_name(index);
+}
+
+void Resolver::QuerySent(const unsigned int index) {
+  PendingResolve& lookup = lookups[index];
+  lookup.next_query_at = millis() + lookup.retry_interval;
+  lookup.retry_interval *= 2;
+}
+
+void Resolver::Answer(const char* name, const IPAddress& address, unsigned long ttl) {
+  const unsigned long now = millis();
+  if (ttl > MDNS_RESOLVE_MAX_TTL) {
+    ttl = MDNS_RESOLVE_MAX_TTL;
+  }
+
+  // Refresh or, for a goodbye packet with a TTL of 0, drop a cached address.
+  bool cached = false;
+  for (unsigned int i = 0; i < cache_count; ++i) {
+    if (cache_name(i)[0] && strcasecmp(cache_name(i), name) == 0) {
+      if (ttl) {
+        cache[i].address = address;
+        cache[i].expires_at = now + ttl * 1000;
+      } else {
+        cache_name(i)[0] = '\0';
+      }
+      cached = true;
+      break;
+    }
+  }
+  if (!ttl) {
+    return;
+  }
+
+  for (unsigned int i = 0; i < lookup_count; ++i) {
+    if (!lookup_name(i)[0] || strcasecmp(lookup_name(i), name) != 0) {
+      continue;
+    }
+    if (!cached && cache_count) {
+      // Replace an empty entry or else the one closest to expiring.
+      unsigned int replace = 0;
+      for (unsigned int j = 0; j < cache_count; ++j) {
+        if (!cache_name(j)[0]) {
+          replace = j;
+          break;
+        }
+        if ((long)(cache[j].expires_at - cache[replace].expires_at) < 0) {
+          replace = j;
+        }
+      }
+      strcpy(cache_name(replace), lookup_name(i));
+      cache[replace].address = address;
+      cache[replace].expires_at = now + ttl * 1000;
+    }
+    Finish(i, address);
+    break;
+  }
+}
+
+void Resolver::EarliestDeadline(unsigned long* deadline) const {
+  for (unsigned int i = 0; i < lookup_count; ++i) {
+    if (lookup_name(i)[0]) {
+      earliestDeadline(deadline, lookups[i].next_query_at);
+      earliestDeadline(deadline, lookups[i].timeout_at);
+    }
+  }
+  for (unsigned int i = 0; i < callback_count; ++i) {
+    if (callbacks[i]) {
+      earliestDeadline(deadline, callback_timeouts[i]);
+    }
+  }
+  for (unsigned int i = 0; i < cache_count; ++i) {
+    if (cache_name(i)[0]) {
+      earliestDeadline(deadline, cache[i].expires_at);
+    }
+  }
+}
+
+void Resolver::Finish(const unsigned int index, const IPAddress& address) {
+  char* name = finished_name();
+  const char* lookup = lookup_name(index);
+  memcpy(name, lookup, strlen(lookup) + 1);
+  lookup_name(index)[0] = '\0';
+
+  for (unsigned int i = 0; i < callback_count; ++i) {
+    if (callbacks[i] && callback_owners[i] == index) {
+      // Release the slot first in case the callback calls resolve() again.
+      ResolveCallback callback = callbacks[i];
+      callbacks[i] = NULL;
+      callback(name, address);
+    }
+  }
+}
+
+} // namespace mdns
@@ -0,0 +1,125 @@
+#ifndef MDNS_RESOLVER_H
+#define MDNS_RESOLVER_H
+
+#include <Arduino.h>
+
+#include <functional>
+
+namespace mdns{
+
+// Called by resolve() with the address found for name.
+// address is 0.0.0.0 if the lookup timed out.
+typedef std::function<void(const char* name, IPAddress address)> ResolveCallback;
+
+// A name resolve() is looking up. Unused if its name is empty.
+struct PendingResolve{
+  unsigned long int timeout_at;      // millis() when the last waiting callback gives up.
+  unsigned long int next_query_at;   // millis() when the query is next sent.
+  unsigned long int retry_interval;
+};
+
+// An address found by resolve(). Unused if its name is empty.
+struct CachedAddress{
+  IPAddress address;
+  unsigned long int expires_at;      // millis() when the TTL runs out.
+};
+
+// Lookups in progress, waiting callbacks and cached addresses for MDns::resolve().
+// Kept out of MDns so instances that never resolve names do not carry the tables.
+// Attach to an MDns with setResolver(). Use BasicResolver<> to have the storage
+// embedded in the object.
+class Resolver {
+ public:
+  // Args:
+  //   lookups_ : Array of lookup_count_ PendingResolve.
+  //   cache_ : Array of cache_count_ CachedAddress.
+  //   callbacks_, callback_owners_, callback_timeouts_ : Arrays of callback_count_ entries.
+  //   names_ : Buffer of (lookup_count_ + cache_count_ + 1) * name_len_ bytes.
+  //   name_len_ : Longest name that can be looked up, including trailing '\0'.
+  Resolver(PendingResolve* lookups_, unsigned int lookup_count_,
+           CachedAddress* cache_, unsigned int cache_count_,
+           ResolveCallback* callbacks_, byte* callback_owners_,
+           unsigned long* callback_timeouts_, unsigned int callback_count_,
+           char* names_, unsigned int name_len_);
+
+  // Start or join a lookup of name. Fires callback straight away if the address
+  // is cached. The query itself is sent by MDns. Each callback fails after its
+  // own timeout_ms; the lookup keeps going while any callback is waiting.
+  // Returns false if there is no room to track the lookup.
+  bool Add(const char* name, ResolveCallback callback, const unsigned long timeout_ms);
+
+  // Expire cached addresses and fail callbacks whose timeout has passed.
+  void RunTimers();
+
+  // Name of lookup index if its query is due, otherwise NULL.
+  const char* DueQuery(const unsigned int index) const;
+
+  // Note that the query for lookup index was sent, and back off the next one.
+  void QuerySent(const unsigned int index);
+
+  // An A record for name arrived. Caches it if it answers a lookup and fires
+  // the lookup's callbacks. A ttl of 0 removes name from the cache.
+  void Answer(const char* name, const IPAddress& address, unsigned long ttl);
+
+  // Move *deadline earlier to the next time RunTimers() or a query is due.
+  void EarliestDeadline(unsigned long* deadline) const;
+
+  // Number of lookups that can be in progress at once.
+  unsigned int max_lookups() const { return lookup_count; }
+
+ private:
+  // BasicResolver points the tables at its own storage so copies would share it.
+  Resolver(const Resolver&) = delete;
+  Resolver& operator=(const Resolver&) = delete;
+
+  // Fire and release the callbacks waiting on a lookup.
+  void Finish(const unsigned int index, const IPAddress& address);
+
+  // Names are kept in names: lookups, then cached addresses, then a copy of
+  // the name being passed to callbacks by Finish().
+  char* lookup_name(const unsigned int index) const { return names + index * name_len; }
+  char* cache_name(const unsigned int index) const {
+    return names + (lookup_count + index) * name_len;
+  }
+  char* finished_name() const { return names + (lookup_count + cache_count) * name_len; }
+
+  PendingResolve* lookups;
+  unsigned int lookup_count;
+  CachedAddress* cache;
+  unsigned int cache_count;
+  ResolveCallback* callbacks;
+  // Index into lookups for each of callbacks.
+  byte* callback_owners;
+  // millis() when each of callbacks gives up.
+  unsigned long* callback_timeouts;
+  unsigned int callback_count;
+  char* names;
+  unsigned int name_len;
+};
+
+// Resolver with storage for Lookups concurrent lookups, Cached addresses and
+// Callbacks waiting callbacks, for names of up to NameLen bytes, embedded in
+// the object.
+// eg: mdns::BasicResolver<> resolver;  my_mdns.setResolver(&resolver);
+template <unsigned int Lookups = MAX_MDNS_PENDING_RESOLVES,
+          unsigned int Cached = MAX_MDNS_RESOLVE_CACHE,
+          unsigned int Callbacks = MAX_MDNS_RESOLVE_CALLBACKS,
+          unsigned int NameLen = MAX_MDNS_NAME_LEN>
+class BasicResolver : public Resolver {
+ public:
+  BasicResolver() : Resolver(lookup_storage, Lookups, cache_storage, Cached,
+                             callback_storage, owner_storage, timeout_storage, Callbacks,
+                             name_storage, NameLen) {}
+
+ private:
+  PendingResolve lookup_storage[Lookups];
+  CachedAddress cache_storage[Cached];
+  ResolveCallback callback_storage[Callbacks];
+  byte owner_storage[Callbacks];
+  unsigned long timeout_storage[Callbacks];
+  char name_storage[(Lookups + Cached + 1) * NameLen];
+};
+
+} // namespace mdns
+
+#endif  // MDNS_RESOLVER_H